@@ -0,0 +1,46 @@
+#include <engine/game/commandbuffer.hpp>
+
+#include <algorithm>
+
+CommandBuffer::PendingEntity CommandBuffer::create() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return {numPending++};
+}
+
+void CommandBuffer::erase(Entity _ent) {
+    std::unique_lock<std::mutex> lock(mutex);
+    erasures.push_back(_ent);
+}
+
+void CommandBuffer::flush(Registry& _registry) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Entities from Registry::createConcurrent() have to be alive before their components are inserted.
+    _registry.commitReserved();
+    std::vector<Entity> created(numPending);
+    for (Entity& ent : created) ent = _registry.create();
+
+    std::stable_sort(commands.begin(), commands.end(), [](const Command& _a, const Command& _b) {
+        return _a.pool < _b.pool;
+    });
+
+    void* pool = nullptr;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const Command& command = commands[i];
+        if (i == 0 || command.pool != commands[i - 1].pool) pool = command.getPool(_registry);
+
+        const Entity ent = command.target.pending ? created[command.target.id] : Entity{command.target.id};
+        if (!_registry.isAlive(ent)) continue;
+
+        command.apply(pool, ent, command.dataOffset == NO_DATA ? nullptr : &data[command.dataOffset]);
+    }
+
+    // Sorted for locality, duplicates are skipped because they are not alive anymore.
+    std::sort(erasures.begin(), erasures.end());
+    _registry.erase(erasures);
+
+    numPending = 0;
+    commands.clear();
+    erasures.clear();
+    data.clear();
+}
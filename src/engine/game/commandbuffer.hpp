@@ -0,0 +1,140 @@
+#pragma once
+
+#include <engine/game/registry.hpp>
+#include <engine/utils/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Records structural changes (create, erase, insert, remove) to apply them later on in one batch.
+// Tags are inserted and removed like components, e.g. insert(ent, Projectile{}) and remove<Projectile>(ent).
+// Recording is thread-safe, so a CommandBuffer can be filled from within execute() and executeParallel()
+// where the registry itself must not be modified. Entities which are needed right away, e.g. to reference
+// them from other components, can be created with Registry::createConcurrent() instead of create().
+class CommandBuffer {
+   public:
+    // Placeholder for an entity which is created on flush().
+    struct PendingEntity {
+        size_t index;
+    };
+
+    PendingEntity create();
+    void erase(Entity _ent);
+
+    template <component_type Component>
+    void insert(Entity _ent, const Component& _comp) {
+        record<Component>({_ent.id, false}, &_comp);
+    }
+
+    template <component_type Component>
+    void insert(PendingEntity _ent, const Component& _comp) {
+        record<Component>({_ent.index, true}, &_comp);
+    }
+
+    // Insert a split_component together with its cold part. The overloads above default construct the
+    // cold part like ComponentAccess::insert(_ent, _comp).
+    template <split_component Component>
+    void insert(Entity _ent, const Component& _comp, const typename Component::ColdPart& _cold) {
+        record<Component>({_ent.id, false}, &_comp, &_cold);
+    }
+
+    template <split_component Component>
+    void insert(PendingEntity _ent, const Component& _comp, const typename Component::ColdPart& _cold) {
+        record<Component>({_ent.index, true}, &_comp, &_cold);
+    }
+
+    template <component_type Component>
+    void remove(Entity _ent) {
+        record<Component>({_ent.id, false}, nullptr);
+    }
+
+    // Apply all recorded operations to _registry and clear the buffer. Must not be called while recording.
+    // Entities reserved with Registry::createConcurrent() are committed first.
+    // Pending entities are created first. Then component insertions and removals are applied grouped by
+    // pool, keeping the recording order within each pool. Entities are erased last.
+    // Operations on entities which are not alive anymore are skipped.
+    void flush(Registry& _registry);
+
+    bool empty() const {
+        return commands.empty() && erasures.empty() && numPending == 0;
+    }
+
+   private:
+    struct Target {
+        uint64_t id;
+        bool pending;
+    };
+
+    struct Command {
+        uint32_t pool;
+        Target target;
+        // Offset of the component in data or NO_DATA for a removal.
+        size_t dataOffset;
+        void* (*getPool)(Registry&);
+        void (*apply)(void* _pool, Entity _ent, const char* _data);
+    };
+
+    static constexpr size_t NO_DATA = ~size_t(0);
+
+    template <typename Component>
+    using ColdPart = typename details::ColdPart<Component>::type;
+
+    // Offset of the cold part behind the copy of a split_component in data.
+    template <typename Component>
+    static constexpr size_t COLD_OFFSET = (sizeof(Component) + alignof(ColdPart<Component>) - 1) / alignof(ColdPart<Component>) *
+                                          alignof(ColdPart<Component>);
+
+    template <component_type Component>
+    void record(Target _target, const Component* _comp, const ColdPart<Component>* _cold = nullptr) {
+        constexpr size_t alignment = std::max(alignof(Component), alignof(ColdPart<Component>));
+        static_assert(alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Over-aligned components are not supported.");
+
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t offset = NO_DATA;
+        if (_comp) {
+            offset = (data.size() + alignment - 1) / alignment * alignment;
+            if constexpr (split_component<Component>) {
+                data.resize(offset + COLD_OFFSET<Component> + sizeof(ColdPart<Component>));
+                new (&data[offset + COLD_OFFSET<Component>]) ColdPart<Component>(_cold ? *_cold : ColdPart<Component>{});
+            } else
+                data.resize(offset + sizeof(Component));
+            new (&data[offset]) Component(*_comp);
+        }
+
+        // Tags share the id space of components, so they are grouped by TagSet in flush() the same way.
+        if constexpr (tag_type<Component>) {
+            commands.push_back({Registry::componentId<Component>(), _target, offset,
+                                [](Registry& _registry) -> void* { return &_registry.getTags<Component>(); },
+                                [](void* _tags, Entity _ent, const char* _data) {
+                                    auto& tags = *static_cast<TagSet*>(_tags);
+                                    if (_data)
+                                        tags.insert(_ent);
+                                    else
+                                        tags.erase(_ent);
+                                }});
+        } else {
+            commands.push_back({Registry::componentId<Component>(), _target, offset,
+                                [](Registry& _registry) -> void* { return &_registry.getComponents<Component>(); },
+                                [](void* _pool, Entity _ent, const char* _data) {
+                                    auto& pool = *static_cast<ComponentAccess<Component>*>(_pool);
+                                    if (!_data)
+                                        pool.erase(_ent);
+                                    else if constexpr (split_component<Component>)
+                                        pool.insert(_ent, *reinterpret_cast<const Component*>(_data),
+                                                    *reinterpret_cast<const ColdPart<Component>*>(_data + COLD_OFFSET<Component>));
+                                    else
+                                        pool.insert(_ent, *reinterpret_cast<const Component*>(_data));
+                                }});
+        }
+    }
+
+    std::mutex mutex;
+    size_t numPending = 0;
+    std::vector<Command> commands;
+    std::vector<Entity> erasures;
+    // Copies of the inserted components.
+    std::vector<char> data;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <engine/game/registry.hpp>
 #include <engine/graphics/core/texture.hpp>
 #include <engine/graphics/renderer/mesh.hpp>
 #include <engine/graphics/renderer/meshrenderer.hpp>
@@ -11,12 +12,30 @@ enum class ColliderType { Projectile,
                           MovingTarget,
                           Target };
 
+// Rarely changing part of a Transform, stored beside the pool of Transforms, see split_component.
+struct TransformScale {
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
 struct Transform {
+    using ColdPart = TransformScale;
+
     glm::vec3 position;
     glm::vec3 velocity;
     glm::vec3 rotation;
     glm::vec3 angularVelocity;
-    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+// Model matrix of a Transform combined with those of its parents, maintained by
+// HierarchySystem::updateWorldMatrices.
+struct WorldTransform {
+    glm::mat4 matrix = glm::mat4(1.0f);
+};
+
+// Attaches an entity to another one. Its Transform is then relative to the WorldTransform of the parent,
+// see HierarchySystem. Assigning a new parent to an existing component requires ComponentAccess::markChanged().
+struct Parent {
+    Entity entity;
 };
 
 struct MeshRender {
@@ -36,10 +55,12 @@ struct PhysicsObject {
 };
 
 struct AABBCollider {
-    ColliderType colliderType;
     math::AABB<3> aabb;
 };
 
+// Tag of entities which destroy the targets they hit.
+struct Projectile {};
+
 struct Light {
     glm::vec3 position;
     glm::vec3 color;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <engine/game/registry.hpp>
+
+#include <array>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+// Read-only copies of the pools of Components... which are published by the update thread
+// and consumed by the render thread. Three frames are kept, so neither publish() nor acquire()
+// has to wait for the other thread to finish its frame.
+template <component_type... Components>
+class FrameSnapshot {
+   public:
+    class Frame {
+       public:
+        template <component_type Component>
+        const ComponentAccess<Component>& get() const {
+            return std::get<ComponentAccess<Component>>(pools);
+        }
+
+        // View over the copied pools, see Registry::view. Components have to be const-qualified.
+        template <typename... Cs>
+        View<Cs...> view() const {
+            static_assert(((std::is_const_v<Cs> || std::is_same_v<Cs, Entity>) && ...), "Frames are read-only.");
+            return View<Cs...>(getPool<Cs>()...);
+        }
+
+        // Number of the publish() call which wrote this frame, 0 if nothing was published yet.
+        uint64_t number() const { return frameNumber; }
+
+       private:
+        friend class FrameSnapshot;
+
+        template <typename T>
+        typename details::PoolPointer<T>::type getPool() const {
+            if constexpr (std::is_same_v<T, Entity>)
+                return nullptr;
+            else
+                return &get<std::remove_const_t<T>>();
+        }
+
+        std::tuple<ComponentAccess<Components>...> pools;
+        uint64_t frameNumber = 0;
+    };
+
+    // Copy the pools of _registry into a free frame and make it the latest one.
+    // Pages of the frame are reused, so this does not allocate once the pools stopped growing.
+    void publish(Registry& _registry) {
+        Frame& frame = frames[writeIndex];
+        ((std::get<ComponentAccess<Components>>(frame.pools) = _registry.getComponents<Components>()), ...);
+        frame.frameNumber = ++numPublished;
+
+        std::scoped_lock lock(mutex);
+        std::swap(writeIndex, readyIndex);
+        hasNewFrame = true;
+    }
+
+    // Get the latest published frame. It remains unchanged until the next call to acquire().
+    const Frame& acquire() {
+        std::scoped_lock lock(mutex);
+        if (hasNewFrame) {
+            std::swap(readIndex, readyIndex);
+            hasNewFrame = false;
+        }
+        return frames[readIndex];
+    }
+
+   private:
+    std::array<Frame, 3> frames;
+    std::mutex mutex;
+    size_t writeIndex = 0;
+    size_t readyIndex = 1;
+    size_t readIndex = 2;
+    bool hasNewFrame = false;
+    uint64_t numPublished = 0;
+};
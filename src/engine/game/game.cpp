@@ -31,15 +31,35 @@ void Game::run() {
         duration_t dt = targetFT;
         glfwSetKeyCallback(window, GameState::keyCallbackDispatch);
         glfwSetMouseButtonCallback(window, GameState::mouseButtonCallbackDispatch);
+        utils::ThreadPool& threadPool = utils::ThreadPool::global();
 
         while (!stateManager.states.empty() && !glfwWindowShouldClose(window)) {
-            stateManager.current->update(t.time_since_epoch().count(), dt.count());
-
-            glCall(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            stateManager.current->draw(t.time_since_epoch().count(), dt.count());
+            GameState& state = *stateManager.current;
+            const float time = t.time_since_epoch().count();
+
+            if (state.drawsConcurrently() && threadPool.numThreads() > 0) {
+                // Draw the last published frame on this thread, which owns the OpenGL context,
+                // while the next frame is updated on a worker. Jobs of the update may run on the
+                // same pool, since parallelFor and the SystemScheduler also work on the calling thread.
+                auto update = std::make_shared<std::packaged_task<void()>>([&]() { state.update(time, dt.count()); });
+                std::future<void> updated = update->get_future();
+                threadPool.run([update]() { (*update)(); });
+
+                glCall(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                state.draw(time, dt.count());
+                glfwSwapBuffers(window);
+
+                updated.get();
+            } else {
+                state.update(time, dt.count());
+
+                glCall(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                state.draw(time, dt.count());
+                glfwSwapBuffers(window);
+            }
 
+            // Input callbacks may modify the state, so events are only processed once the update finished.
             glfwPollEvents();
-            glfwSwapBuffers(window);
 
             if (stateManager.current->isFinished())
                 stateManager.deleteLastState();
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include <chrono>
+#include <future>
 #include <engine/game/game.hpp>
 #include <engine/game/registry.hpp>
 #include <engine/game/states/statemanager.hpp>
@@ -16,7 +17,9 @@
 #include <engine/graphics/renderer/meshrenderer.hpp>
 #include <engine/input/inputmanager.hpp>
 #include <engine/utils/meshloader.hpp>
+#include <engine/utils/threadpool.hpp>
 #include <iostream>
+#include <memory>
 #include <thread>
 #include <vector>
 
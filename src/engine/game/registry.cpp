@@ -0,0 +1,401 @@
+#include "registry.hpp"
+
+#include <engine/utils/mappedfile.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+
+namespace {
+constexpr char SNAPSHOT_MAGIC[8] = {'A', 'C', 'A', 'R', 'E', 'G', '\0', '\0'};
+constexpr uint32_t SNAPSHOT_VERSION = 4;
+
+// Layout: SnapshotHeader, entity slots, then every pool as
+// PoolHeader, entities, sparse index pages (page number followed by the page), component data and cold parts,
+// followed by every TagSet as TagHeader and its words.
+// Every section is padded to a multiple of 8 bytes.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numPools;
+    uint64_t numEntities;
+    uint64_t freeList;
+    uint64_t numTagSets;
+};
+
+struct PoolHeader {
+    uint64_t type;
+    uint64_t componentSize;
+    uint64_t coldSize;
+    uint64_t size;
+    uint64_t numSparsePages;
+};
+
+struct TagHeader {
+    uint64_t type;
+    uint64_t size;
+    uint64_t numWords;
+};
+
+using Pool = ComponentAccess<char>;
+
+size_t padded(size_t _bytes) {
+    return (_bytes + 7) / 8 * 8;
+}
+
+size_t sparsePageBytes() {
+    return sizeof(uint64_t) + Pool::SPARSE_PAGE_SIZE * sizeof(uint32_t);
+}
+
+// Bounds checked sequential access to the mapped file.
+class Reader {
+   public:
+    Reader(const utils::MappedFile& _file) : file(_file) {}
+
+    bool read(void* _destination, size_t _bytes) {
+        const char* source = skip(_bytes);
+        if (source) std::memcpy(_destination, source, _bytes);
+        return source;
+    }
+
+    // @return The start of the skipped section or nullptr if the file is too short.
+    const char* skip(size_t _bytes) {
+        if (file.size() - offset < _bytes) return nullptr;
+        const char* section = file.data() + offset;
+        offset += _bytes;
+        return section;
+    }
+
+   private:
+    const utils::MappedFile& file;
+    size_t offset = 0;
+};
+}  // namespace
+
+bool Registry::save(const std::string& _fileName) const {
+    std::ofstream file(_fileName, std::ios::binary);
+    if (!file) {
+        spdlog::error("[game] Could not open '{}' for writing.", _fileName);
+        return false;
+    }
+
+    auto write = [&](const void* _data, size_t _bytes) {
+        file.write(static_cast<const char*>(_data), _bytes);
+    };
+    auto pad = [&](size_t _bytes) {
+        static const char zeros[8] = {};
+        write(zeros, padded(_bytes) - _bytes);
+    };
+
+    std::vector<const Pool*> saved;
+    for (auto& pool : pools) {
+        if (pool) saved.push_back(pool.get());
+    }
+    for (auto& [type, pool] : unboundPools) saved.push_back(pool.get());
+    std::vector<const TagSet*> savedTags;
+    for (auto& tags : tagSets) {
+        if (tags) savedTags.push_back(tags.get());
+    }
+    for (auto& [type, tags] : unboundTags) savedTags.push_back(&tags);
+
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.numPools = static_cast<uint32_t>(saved.size());
+    header.numEntities = slots.size();
+    header.freeList = freeList;
+    header.numTagSets = savedTags.size();
+    write(&header, sizeof(header));
+    write(slots.data(), slots.size() * sizeof(Entity));
+
+    for (const Pool* pool : saved) {
+        PoolHeader poolHeader;
+        poolHeader.type = pool->typeHash;
+        poolHeader.componentSize = pool->componentSize;
+        poolHeader.coldSize = pool->coldSize;
+        poolHeader.size = pool->size();
+        poolHeader.numSparsePages = std::count_if(pool->sparsePages.begin(), pool->sparsePages.end(), [](const auto& _page) { return _page != nullptr; });
+        write(&poolHeader, sizeof(poolHeader));
+
+        write(pool->entities.data(), pool->entities.size() * sizeof(Entity));
+        for (size_t i = 0; i < pool->sparsePages.size(); ++i) {
+            if (!pool->sparsePages[i]) continue;
+            const uint64_t page = i;
+            write(&page, sizeof(page));
+            write(pool->sparsePages[i].get(), Pool::SPARSE_PAGE_SIZE * sizeof(uint32_t));
+        }
+        for (size_t begin = 0; begin < pool->size(); begin += Pool::PAGE_SIZE)
+            write(pool->element(begin), std::min(Pool::PAGE_SIZE, pool->size() - begin) * pool->componentSize);
+        pad(pool->size() * pool->componentSize);
+        for (size_t begin = 0; pool->coldSize && begin < pool->size(); begin += Pool::PAGE_SIZE)
+            write(pool->coldElement(begin), std::min(Pool::PAGE_SIZE, pool->size() - begin) * pool->coldSize);
+        pad(pool->size() * pool->coldSize);
+    }
+
+    for (const TagSet* tags : savedTags) {
+        const TagHeader tagHeader{tags->typeHash, tags->count, tags->words.size()};
+        write(&tagHeader, sizeof(tagHeader));
+        write(tags->words.data(), tags->words.size() * sizeof(uint64_t));
+    }
+
+    if (!file) {
+        spdlog::error("[game] Could not write snapshot '{}'.", _fileName);
+        return false;
+    }
+    return true;
+}
+
+bool Registry::load(const std::string& _fileName) {
+    const utils::MappedFile file(_fileName);
+    if (!file.isOpen()) {
+        spdlog::error("[game] Could not open snapshot '{}'.", _fileName);
+        return false;
+    }
+
+    // Validate the whole file first, so that the registry stays unchanged on errors.
+    Reader reader(file);
+    SnapshotHeader header;
+    if (!reader.read(&header, sizeof(header)) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        spdlog::error("[game] '{}' is not a registry snapshot.", _fileName);
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        spdlog::error("[game] Snapshot '{}' has version {}, expected {}.", _fileName, header.version, SNAPSHOT_VERSION);
+        return false;
+    }
+
+    // Reject counts larger than the file before they are multiplied with sizes.
+    const char* slotData = header.numEntities <= file.size() ? reader.skip(header.numEntities * sizeof(Entity)) : nullptr;
+    bool valid = slotData != nullptr;
+
+    std::vector<std::pair<PoolHeader, const char*>> poolSections;
+    for (uint32_t i = 0; valid && i < header.numPools; ++i) {
+        PoolHeader poolHeader;
+        if (!reader.read(&poolHeader, sizeof(poolHeader))) {
+            valid = false;
+            break;
+        }
+        if (poolHeader.size > file.size() || poolHeader.numSparsePages > file.size() || poolHeader.componentSize > file.size() ||
+            poolHeader.coldSize > file.size()) {
+            valid = false;
+            break;
+        }
+        const char* section = reader.skip(poolHeader.size * sizeof(Entity) + poolHeader.numSparsePages * sparsePageBytes() +
+                                          padded(poolHeader.size * poolHeader.componentSize) + padded(poolHeader.size * poolHeader.coldSize));
+        valid = section && poolHeader.componentSize > 0;
+        poolSections.emplace_back(poolHeader, section);
+    }
+    std::vector<std::pair<TagHeader, const char*>> tagSections;
+    for (uint64_t i = 0; valid && i < header.numTagSets; ++i) {
+        TagHeader tagHeader;
+        const char* words = reader.read(&tagHeader, sizeof(tagHeader)) && tagHeader.numWords <= file.size()
+                                ? reader.skip(tagHeader.numWords * sizeof(uint64_t))
+                                : nullptr;
+        valid = words != nullptr;
+        tagSections.emplace_back(tagHeader, words);
+    }
+    if (!valid) {
+        spdlog::error("[game] Snapshot '{}' is truncated.", _fileName);
+        return false;
+    }
+
+    // Check that every entity of a pool section is alive and that the sparse index is exactly the inverse
+    // of the dense array: sparse[entities[i]] == i for every i and no other entries. Every sparse page
+    // has to lie within the loaded slots and may only occur once.
+    auto validPool = [&](const PoolHeader& _header, const char* _section) {
+        const char* sparseSection = _section + _header.size * sizeof(Entity);
+        const uint64_t numPages = (header.numEntities + Pool::SPARSE_PAGE_SIZE - 1) / Pool::SPARSE_PAGE_SIZE;
+        std::vector<const char*> pages(numPages, nullptr);
+        uint64_t numEntries = 0;
+        for (uint64_t i = 0; i < _header.numSparsePages; ++i) {
+            const char* page = sparseSection + i * sparsePageBytes();
+            uint64_t pageNumber;
+            std::memcpy(&pageNumber, page, sizeof(pageNumber));
+            if (pageNumber >= numPages || pages[pageNumber]) return false;
+            pages[pageNumber] = page + sizeof(pageNumber);
+            for (size_t j = 0; j < Pool::SPARSE_PAGE_SIZE; ++j) {
+                uint32_t index;
+                std::memcpy(&index, pages[pageNumber] + j * sizeof(index), sizeof(index));
+                if (index != Pool::INVALID_INDEX) ++numEntries;
+            }
+        }
+        // With one matching entry per entity, equal counts leave no room for orphaned entries.
+        if (numEntries != _header.size) return false;
+
+        for (uint64_t i = 0; i < _header.size; ++i) {
+            Entity ent;
+            std::memcpy(&ent, _section + i * sizeof(Entity), sizeof(Entity));
+            if (ent.index() >= header.numEntities) return false;
+            Entity slot;
+            std::memcpy(&slot, slotData + ent.index() * sizeof(Entity), sizeof(Entity));
+            const char* page = pages[ent.index() / Pool::SPARSE_PAGE_SIZE];
+            if (slot != ent || !page) return false;
+            uint32_t index;
+            std::memcpy(&index, page + ent.index() % Pool::SPARSE_PAGE_SIZE * sizeof(index), sizeof(index));
+            if (index != i) return false;
+        }
+        return true;
+    };
+    // Every index is used to address memory, so a corrupt file must not get past this point.
+    valid = header.freeList == NO_INDEX || header.freeList < header.numEntities;
+    for (uint64_t i = 0; valid && i < header.numEntities; ++i) {
+        // Erased slots link to the next free index.
+        Entity slot;
+        std::memcpy(&slot, slotData + i * sizeof(Entity), sizeof(Entity));
+        valid = slot.index() == NO_INDEX || slot.index() < header.numEntities;
+    }
+    for (auto& [poolHeader, section] : poolSections) {
+        if (valid) valid = validPool(poolHeader, section);
+    }
+    if (!valid) {
+        spdlog::error("[game] Snapshot '{}' is corrupt.", _fileName);
+        return false;
+    }
+
+    // Pools clear their bits in the masks of the current entities, so they are cleared before the masks are resized.
+    for (auto& pool : pools) {
+        if (pool) pool->clear();
+    }
+    unboundPools.clear();
+    for (auto& tags : tagSets) {
+        if (tags) tags->clear();
+    }
+    unboundTags.clear();
+
+    slots.resize(header.numEntities);
+    std::memcpy(slots.data(), slotData, header.numEntities * sizeof(Entity));
+    freeList = static_cast<uint32_t>(header.freeList);
+    reservedHead = freeList;
+    reservedEnd = static_cast<uint32_t>(header.numEntities);
+    masks->assign(header.numEntities, 0);
+
+    for (auto& [poolHeader, section] : poolSections) {
+        auto it = std::find_if(pools.begin(), pools.end(), [&](const auto& _pool) { return _pool && _pool->typeHash == poolHeader.type; });
+        Pool* pool = nullptr;
+        if (it != pools.end()) {
+            pool = it->get();
+            if (pool->componentSize != poolHeader.componentSize || pool->coldSize != poolHeader.coldSize) {
+                spdlog::error("[game] Component size in snapshot '{}' does not match, the component is skipped.", _fileName);
+                continue;
+            }
+        } else {
+            auto unbound = std::make_unique<Pool>();
+            unbound->componentSize = poolHeader.componentSize;
+            unbound->coldSize = poolHeader.coldSize;
+            unbound->typeHash = poolHeader.type;
+            pool = unbound.get();
+            unboundPools[poolHeader.type] = std::move(unbound);
+        }
+
+        pool->reserve(poolHeader.size);
+        pool->entities.resize(poolHeader.size);
+        std::memcpy(pool->entities.data(), section, poolHeader.size * sizeof(Entity));
+        pool->changed.assign(poolHeader.size, 1);
+        section += poolHeader.size * sizeof(Entity);
+
+        for (uint64_t i = 0; i < poolHeader.numSparsePages; ++i) {
+            uint64_t page;
+            std::memcpy(&page, section, sizeof(page));
+            if (page >= pool->sparsePages.size()) pool->sparsePages.resize(page + 1);
+            pool->sparsePages[page].reset(new uint32_t[Pool::SPARSE_PAGE_SIZE]);
+            std::memcpy(pool->sparsePages[page].get(), section + sizeof(page), Pool::SPARSE_PAGE_SIZE * sizeof(uint32_t));
+            section += sparsePageBytes();
+        }
+
+        for (size_t begin = 0; begin < poolHeader.size; begin += Pool::PAGE_SIZE) {
+            const size_t bytes = std::min<size_t>(Pool::PAGE_SIZE, poolHeader.size - begin) * pool->componentSize;
+            std::memcpy(pool->element(begin), section, bytes);
+            section += bytes;
+        }
+        section += padded(poolHeader.size * pool->componentSize) - poolHeader.size * pool->componentSize;
+        for (size_t begin = 0; pool->coldSize && begin < poolHeader.size; begin += Pool::PAGE_SIZE) {
+            const size_t bytes = std::min<size_t>(Pool::PAGE_SIZE, poolHeader.size - begin) * pool->coldSize;
+            std::memcpy(pool->coldElement(begin), section, bytes);
+            section += bytes;
+        }
+
+        if (pool->masks) {
+            for (Entity ent : pool->entities) (*masks)[ent.index()] |= pool->maskBit;
+        }
+        if (!pool->insertSignal.empty()) {
+            for (Entity ent : pool->entities) pool->insertSignal.emit(ent);
+        }
+    }
+
+    for (auto& [tagHeader, words] : tagSections) {
+        auto it = std::find_if(tagSets.begin(), tagSets.end(), [&](const auto& _tags) { return _tags && _tags->typeHash == tagHeader.type; });
+        TagSet& tags = it != tagSets.end() ? **it : unboundTags[tagHeader.type];
+        tags.typeHash = tagHeader.type;
+        tags.count = tagHeader.size;
+        tags.words.resize(tagHeader.numWords);
+        std::memcpy(tags.words.data(), words, tagHeader.numWords * sizeof(uint64_t));
+    }
+
+    for (auto& group : groups) group->detach();
+    for (auto& group : groups) group->attach();
+
+    return true;
+}
+
+void Registry::bindPool(uint32_t _id) {
+    Pool& pool = *pools[_id];
+    auto it = unboundPools.find(pool.typeHash);
+    if (it == unboundPools.end()) return;
+
+    if (it->second->componentSize == pool.componentSize && it->second->coldSize == pool.coldSize) {
+        std::vector<ComponentMask>* poolMasks = pool.masks;
+        const ComponentMask maskBit = pool.maskBit;
+        const std::string_view typeName = pool.typeName;
+        pool = std::move(*it->second);
+        pool.masks = poolMasks;
+        pool.maskBit = maskBit;
+        pool.typeName = typeName;
+        for (Entity ent : pool.entities) (*masks)[ent.index()] |= maskBit;
+    } else
+        spdlog::error("[game] Component size in snapshot does not match, the component is skipped.");
+
+    unboundPools.erase(it);
+}
+
+void Registry::bindTags(uint32_t _id) {
+    TagSet& tags = *tagSets[_id];
+    auto it = unboundTags.find(tags.typeHash);
+    if (it == unboundTags.end()) return;
+
+    tags = std::move(it->second);
+    unboundTags.erase(it);
+}
+
+std::vector<PoolStats> Registry::stats() const {
+    std::vector<PoolStats> result;
+    for (auto& pool : pools) {
+        if (pool) result.push_back(pool->stats());
+    }
+    for (auto& [type, pool] : unboundPools) result.push_back(pool->stats());
+    return result;
+}
+
+void Registry::logStats() const {
+    size_t totalBytes = 0;
+    for (const PoolStats& pool : stats()) {
+        spdlog::info("[game] {}: {} of {} components, sparse {}, {} bytes (peak {}), +{} -{}", pool.name.empty() ? "<unbound>" : pool.name,
+                     pool.size, pool.capacity, pool.sparseSize, pool.bytes, pool.peakBytes, pool.inserts, pool.erases);
+        totalBytes += pool.bytes;
+    }
+    spdlog::info("[game] {} entity slots, {} bytes in pools.", slots.size(), totalBytes);
+}
+
+nlohmann::json Registry::statsJson() const {
+    nlohmann::json result = nlohmann::json::array();
+    for (const PoolStats& pool : stats()) {
+        result.push_back({{"name", pool.name},
+                          {"size", pool.size},
+                          {"capacity", pool.capacity},
+                          {"sparseSize", pool.sparseSize},
+                          {"bytes", pool.bytes},
+                          {"peakBytes", pool.peakBytes},
+                          {"inserts", pool.inserts},
+                          {"erases", pool.erases}});
+    }
+    return result;
+}
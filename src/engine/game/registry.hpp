@@ -1,66 +1,331 @@
 #pragma once
+#include <algorithm>
 #include <any>
+#include <atomic>
+#include <bit>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <numeric>
 #include <optional>
-#include <typeindex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include <engine/utils/assert.hpp>
+#include <engine/utils/metaproghelpers.hpp>
+#include <engine/utils/threadpool.hpp>
+#include <engine/utils/typeindex.hpp>
+#include <nlohmann/json_fwd.hpp>
+#include <static_type_info.h>
+
+// Handle of an entity. The lower 32 bits are the index, which is reused once the entity is erased,
+// the upper 32 bits the generation of the index, so that stale handles can be detected.
 struct Entity {
     uint64_t id;
-};
 
-struct EntityRef {
-    Entity entity;
-    uint64_t generation;
+    static constexpr Entity make(uint32_t _index, uint32_t _generation) {
+        return {static_cast<uint64_t>(_generation) << 32 | _index};
+    }
+
+    constexpr uint32_t index() const { return static_cast<uint32_t>(id); }
+    constexpr uint32_t generation() const { return static_cast<uint32_t>(id >> 32); }
 };
 
+// Handles already contain their generation, see Registry::getEntity.
+using EntityRef = Entity;
+
 inline bool operator==(const Entity& a, const Entity& b) {
     return a.id == b.id;
 }
 
+// Ordered by index first, which is the order of the Registry arrays.
 inline bool operator<(const Entity& a, const Entity& b) {
-    return a.id < b.id;
+    return a.index() < b.index() || (a.index() == b.index() && a.generation() < b.generation());
 }
 
 template <class T>
 concept component_type = std::movable<T> && std::is_trivially_destructible_v<T>;
 
+template <typename Component>
+struct Changed;
+template <typename Component>
+struct Cold;
+
+// Components without data, which are stored in a TagSet instead of a pool.
+template <class T>
+concept tag_type = !utils::is_specialization_v<T, Changed> && !utils::is_specialization_v<T, Cold> && component_type<T> && std::is_empty_v<T>;
+
+// Components which move rarely accessed fields into a separate type, declared as `using ColdPart = ...;`.
+// The cold parts are stored in separate pages of the same pool at the same dense index, so that iterating
+// the component only touches its hot fields. They are requested with Cold<T> in queries.
+template <class T>
+concept split_component = component_type<T> && requires { typename T::ColdPart; } && component_type<typename T::ColdPart>;
+
+// Set of component types of an entity with one bit per pool of a Registry, in the order the pools were created.
+// Pools beyond MAX_COMPONENTS have no bit and are searched when an entity is erased.
+using ComponentMask = uint64_t;
+constexpr size_t MAX_COMPONENTS = sizeof(ComponentMask) * 8;
+
+template <component_type Component>
+class ComponentAccess;
+
+namespace details {
+struct NoColdPart {};
+
+template <typename T>
+struct ColdPart {
+    using type = NoColdPart;
+};
+template <split_component T>
+struct ColdPart<T> {
+    using type = typename T::ColdPart;
+};
+
+// Shared state of an owning Group. All owned pools keep the entities of the group
+// in the same order at the front of their dense arrays, i.e. in [0, size).
+struct GroupData {
+    // Sorted component ids of the owned pools.
+    std::vector<uint32_t> types;
+    std::vector<ComponentAccess<char>*> pools;
+    uint32_t size = 0;
+
+    // Move _ent into the group if it has all owned components.
+    void add(Entity _ent);
+    // Move _ent out of the group if it is part of it.
+    void remove(Entity _ent);
+    // Register with the owned pools and collect all entities which already have the components.
+    void attach();
+    void detach();
+};
+}  // namespace details
+
+// Callback of a ComponentSignal. It is a plain function pointer with a context pointer,
+// so emitting a signal involves neither virtual calls nor std::function.
+struct ComponentListener {
+    void (*function)(void* _context, Entity _ent);
+    void* context;
+
+    // Listener which calls (_context.*Method)(Entity).
+    template <auto Method, typename T>
+    static ComponentListener bind(T& _context) {
+        return {[](void* _ctx, Entity _ent) { (static_cast<T*>(_ctx)->*Method)(_ent); }, &_context};
+    }
+
+    // Listener which calls Function(Entity).
+    template <auto Function>
+    static ComponentListener bind() {
+        return {[](void*, Entity _ent) { Function(_ent); }, nullptr};
+    }
+
+    bool operator==(const ComponentListener&) const = default;
+};
+
+// List of listeners which are called for every emitted entity.
+// Listeners must not connect or disconnect listeners of the same signal while it is emitted.
+class ComponentSignal {
+   public:
+    // Add _listener unless it is already connected.
+    void connect(ComponentListener _listener) {
+        if (std::find(listeners.begin(), listeners.end(), _listener) == listeners.end()) listeners.push_back(_listener);
+    }
+
+    void disconnect(ComponentListener _listener) {
+        listeners.erase(std::remove(listeners.begin(), listeners.end(), _listener), listeners.end());
+    }
+
+    bool empty() const {
+        return listeners.empty();
+    }
+
+    void emit(Entity _ent) const {
+        for (const ComponentListener& listener : listeners) listener.function(listener.context, _ent);
+    }
+
+   private:
+    std::vector<ComponentListener> listeners;
+};
+
+// Memory and occupancy of a pool, see ComponentAccess::stats.
+struct PoolStats {
+    // Name of the component type, empty for pools of a snapshot whose type was not used yet.
+    std::string_view name;
+    size_t size;
+    // Number of components which fit into the allocated pages.
+    size_t capacity;
+    // Number of entries of the sparse index which are backed by an allocated page.
+    size_t sparseSize;
+    // Bytes allocated for pages, the sparse index and the dense arrays.
+    size_t bytes;
+    size_t peakBytes;
+    // Inserted and erased components since the last resetChurn().
+    uint64_t inserts;
+    uint64_t erases;
+};
+
 template <component_type Component>
 class ComponentAccess {
    public:
-    ComponentAccess() : componentSize(sizeof(Component)) {}
+    // Number of components per page. Pages are never moved, so references to components
+    // remain valid until the component itself is erased or, for pools owned by a Group,
+    // until a component of the group is inserted or erased.
+    static constexpr size_t PAGE_SIZE = 1024;
+    static constexpr size_t PAGE_ALIGNMENT = 64;
+    // Number of entity ids per page of the sparse index. Pages are only allocated for id ranges
+    // which contain at least one entity with this component.
+    static constexpr size_t SPARSE_PAGE_SIZE = 4096;
+
+    // Cold fields of a split_component, see cold().
+    using ColdPart = typename details::ColdPart<Component>::type;
+
+    ComponentAccess() : componentSize(sizeof(Component)), coldSize(split_component<Component> ? sizeof(ColdPart) : 0) {
+        static_assert(alignof(Component) <= PAGE_ALIGNMENT, "Component alignment exceeds the page alignment.");
+        static_assert(alignof(ColdPart) <= PAGE_ALIGNMENT, "Cold part alignment exceeds the page alignment.");
+    }
+
+    ComponentAccess(const ComponentAccess& _other) : componentSize(_other.componentSize), coldSize(_other.coldSize) {
+        *this = _other;
+    }
+
+    ComponentAccess(ComponentAccess&&) noexcept = default;
+
+    // Copy all components, reusing the pages which are already allocated.
+    // Pools owned by a Registry cannot be assigned to.
+    ComponentAccess& operator=(const ComponentAccess& _other) {
+        if (this == &_other) return *this;
+        ASSERT(!masks && groups.empty(), "Cannot assign to a pool of a Registry.");
+
+        if (componentSize != _other.componentSize) pages.clear();
+        if (coldSize != _other.coldSize) coldPages.clear();
+        componentSize = _other.componentSize;
+        coldSize = _other.coldSize;
+        typeHash = _other.typeHash;
+        typeName = _other.typeName;
+        entities = _other.entities;
+        changed = _other.changed;
+
+        sparsePages.resize(_other.sparsePages.size());
+        for (size_t i = 0; i < sparsePages.size(); ++i) {
+            if (!_other.sparsePages[i]) {
+                sparsePages[i].reset();
+                continue;
+            }
+            if (!sparsePages[i]) sparsePages[i].reset(new uint32_t[SPARSE_PAGE_SIZE]);
+            std::memcpy(sparsePages[i].get(), _other.sparsePages[i].get(), SPARSE_PAGE_SIZE * sizeof(uint32_t));
+        }
+
+        reserve(entities.size());
+        for (size_t begin = 0; begin < entities.size(); begin += PAGE_SIZE) {
+            const size_t count = std::min(PAGE_SIZE, entities.size() - begin);
+            std::memcpy(element(begin), _other.element(begin), count * componentSize);
+            if (coldSize) std::memcpy(coldElement(begin), _other.coldElement(begin), count * coldSize);
+        }
+        return *this;
+    }
+
+    ComponentAccess& operator=(ComponentAccess&&) noexcept = default;
 
     // Add a new component to an existing entity. No changes are done if Component
     // if _ent already has a component of this type.
+    // The cold part of a split_component is default constructed.
     // @return A reference to the new component or the already existing component.
     Component& insert(Entity _ent, const Component& _comp) {
-        if (sparse.size() > _ent.id && sparse[_ent.id] != -1) {
+        if (hasEntity(_ent)) {
             return *at(_ent);
         }
 
-        if (sparse.size() <= _ent.id)
-            sparse.resize(_ent.id + 1, -1);  // Expand sparse array to fit entity id
+        construct(_ent, _comp, ColdPart{});
+        notifyInsert(_ent);
+        return *at(_ent);
+    }
 
-        sparse[_ent.id] = entities.size();
-        entities.push_back(_ent);
-        buffer.resize(componentSize * entities.size());
-        Component* component = at(_ent);
-        *component = _comp;
+    // Add a split_component together with its cold part.
+    Component& insert(Entity _ent, const Component& _comp, const ColdPart& _cold)
+        requires split_component<Component>
+    {
+        if (hasEntity(_ent)) {
+            return *at(_ent);
+        }
 
-        return *component;
+        construct(_ent, _comp, _cold);
+        notifyInsert(_ent);
+        return *at(_ent);
+    }
+
+    // Add the same component to all _entities. Entities which already have a component are skipped.
+    void insertRange(std::span<const Entity> _entities, const Component& _comp) {
+        reserve(entities.size() + _entities.size());
+        for (Entity ent : _entities) {
+            if (hasEntity(ent)) continue;
+            construct(ent, _comp, ColdPart{});
+            notifyInsert(ent);
+        }
+    }
+
+    // Add _comps[i] to _entities[i]. Entities which already have a component are skipped.
+    void insertRange(std::span<const Entity> _entities, std::span<const Component> _comps) {
+        reserve(entities.size() + _entities.size());
+        for (size_t i = 0; i < _entities.size(); ++i) {
+            if (hasEntity(_entities[i])) continue;
+            construct(_entities[i], _comps[i], ColdPart{});
+            notifyInsert(_entities[i]);
+        }
     }
 
     // Retrieve a component of _ent.
     // @return A pointer to the associated component or nullptr if it does not exist.
     Component* at(Entity _ent) {
-        if (_ent.id >= sparse.size() || sparse[_ent.id] == -1) return nullptr;
-        return reinterpret_cast<Component*>(buffer.data()) + sparse[_ent.id];
+        const uint32_t index = denseIndex(_ent);
+        if (index == INVALID_INDEX) return nullptr;
+        return reinterpret_cast<Component*>(element(index));
     }
 
     const Component* at(Entity _ent) const {
-        if (_ent.id >= sparse.size() || sparse[_ent.id] == -1) return nullptr;
-        return reinterpret_cast<const Component*>(buffer.data()) + sparse[_ent.id];
+        const uint32_t index = denseIndex(_ent);
+        if (index == INVALID_INDEX) return nullptr;
+        return reinterpret_cast<const Component*>(element(index));
+    }
+
+    // Component at position _index of the dense array, which has the same order as getEntities().
+    Component& atIndex(size_t _index) {
+        return *reinterpret_cast<Component*>(element(_index));
+    }
+
+    const Component& atIndex(size_t _index) const {
+        return *reinterpret_cast<const Component*>(element(_index));
+    }
+
+    // Cold part of the component of _ent or nullptr if it does not exist.
+    ColdPart* cold(Entity _ent)
+        requires split_component<Component>
+    {
+        const uint32_t index = denseIndex(_ent);
+        if (index == INVALID_INDEX) return nullptr;
+        return reinterpret_cast<ColdPart*>(coldElement(index));
+    }
+
+    const ColdPart* cold(Entity _ent) const
+        requires split_component<Component>
+    {
+        const uint32_t index = denseIndex(_ent);
+        if (index == INVALID_INDEX) return nullptr;
+        return reinterpret_cast<const ColdPart*>(coldElement(index));
+    }
+
+    ColdPart& coldAtIndex(size_t _index)
+        requires split_component<Component>
+    {
+        return *reinterpret_cast<ColdPart*>(coldElement(_index));
+    }
+
+    const ColdPart& coldAtIndex(size_t _index) const
+        requires split_component<Component>
+    {
+        return *reinterpret_cast<const ColdPart*>(coldElement(_index));
     }
 
     // BONUS:
@@ -68,97 +333,928 @@ class ComponentAccess {
         return *at(_ent);
     }
 
-    bool hasEntity(Entity _ent) {
-        return !(_ent.id >= sparse.size() || sparse[_ent.id] == -1);
+    bool hasEntity(Entity _ent) const {
+        return denseIndex(_ent) != INVALID_INDEX;
     }
 
     // Remove a component from an existing entity.
     // Does not check whether it exists.
     void erase(Entity _ent) {
-        if (_ent.id >= sparse.size() || sparse[_ent.id] == -1) return;
+        uint32_t position = denseIndex(_ent);
+        if (position == INVALID_INDEX) return;
+        eraseSignal.emit(_ent);
 
-        for (uint64_t i = 0; i < componentSize; i++) {
-            buffer[sparse[_ent.id] * componentSize + i] = buffer[componentSize * entities.size() - componentSize + i];
+        if (!groups.empty()) {
+            for (auto it = groups.rbegin(); it != groups.rend(); ++it) (*it)->remove(_ent);
+            position = denseIndex(_ent);
         }
+        if (masks) std::atomic_ref((*masks)[_ent.index()]).fetch_and(~maskBit, std::memory_order_relaxed);
 
-        uint64_t position = sparse[_ent.id];
-        sparse[entities[entities.size() - 1].id] = position;
-        sparse[_ent.id] = -1;
+        const uint32_t last = static_cast<uint32_t>(entities.size() - 1);
+        if (position != last) {
+            std::memcpy(element(position), element(last), componentSize);
+            if (coldSize) std::memcpy(coldElement(position), coldElement(last), coldSize);
+            sparseIndex(entities[last]) = position;
+            entities[position] = entities[last];
+            changed[position] = changed[last];
+        }
 
-        entities[position] = entities[entities.size() - 1];
+        sparseIndex(_ent) = INVALID_INDEX;
         entities.pop_back();
+        changed.pop_back();
+        ++numErases;
+    }
+
+    // Modify the component of _ent through _func(Component&), flag it as changed and emit onUpdate().
+    // @return The modified component or nullptr if _ent has none.
+    template <typename Func>
+    Component* patch(Entity _ent, const Func& _func) {
+        Component* component = at(_ent);
+        if (!component) return nullptr;
+        _func(*component);
+        markChanged(_ent);
+        updateSignal.emit(_ent);
+        return component;
+    }
+
+    // Emitted after a component was inserted and before a component is erased,
+    // for Registry::load and clear() as well. Listeners must not insert or erase components of this pool.
+    ComponentSignal& onInsert() {
+        return insertSignal;
+    }
+
+    ComponentSignal& onErase() {
+        return eraseSignal;
+    }
+
+    // Emitted by patch(). markChanged() does not emit it, since it may be called concurrently.
+    ComponentSignal& onUpdate() {
+        return updateSignal;
+    }
+
+    // Flag the component of _ent as changed. Inserting a component flags it as well.
+    // Different entities can be flagged concurrently, e.g. from View::eachParallel.
+    void markChanged(Entity _ent) {
+        const uint32_t index = denseIndex(_ent);
+        if (index != INVALID_INDEX) changed[index] = 1;
+    }
+
+    // @return Whether _ent has this component and it was flagged since the last clearChanged().
+    bool isChanged(Entity _ent) const {
+        const uint32_t index = denseIndex(_ent);
+        return index != INVALID_INDEX && changed[index];
+    }
+
+    // Flag the component at position _index of the dense array, see markChanged().
+    void markChangedAt(size_t _index) {
+        changed[_index] = 1;
+    }
 
-        uint64_t newSize = componentSize * entities.size();
-        buffer.resize(newSize);
+    void clearChanged() {
+        std::fill(changed.begin(), changed.end(), uint8_t(0));
+    }
+
+    // Allocate memory for at least _count components. Erasing components never releases memory.
+    void reserve(size_t _count) {
+        entities.reserve(_count);
+        changed.reserve(_count);
+        if (pages.size() * PAGE_SIZE >= _count) return;
+        while (pages.size() * PAGE_SIZE < _count) {
+            pages.emplace_back(static_cast<char*>(::operator new[](PAGE_SIZE * componentSize, std::align_val_t{PAGE_ALIGNMENT})));
+            if (coldSize) coldPages.emplace_back(static_cast<char*>(::operator new[](PAGE_SIZE * coldSize, std::align_val_t{PAGE_ALIGNMENT})));
+        }
+        updatePeakBytes();
+    }
+
+    // Remove all components but keep the allocated pages.
+    void clear() {
+        if (!eraseSignal.empty()) {
+            for (Entity ent : entities) eraseSignal.emit(ent);
+        }
+        if (masks) {
+            for (Entity ent : entities) std::atomic_ref((*masks)[ent.index()]).fetch_and(~maskBit, std::memory_order_relaxed);
+        }
+        for (details::GroupData* group : groups) group->size = 0;
+        numErases += entities.size();
+        entities.clear();
+        changed.clear();
+        sparsePages.clear();
+    }
+
+    // Release all pages which are not needed for the current components,
+    // including pages of the sparse index which do not reference any component.
+    void shrinkToFit() {
+        updatePeakBytes();
+        pages.resize((entities.size() + PAGE_SIZE - 1) / PAGE_SIZE);
+        if (coldSize) coldPages.resize(pages.size());
+        entities.shrink_to_fit();
+        changed.shrink_to_fit();
+
+        for (auto& page : sparsePages) {
+            if (page && std::all_of(page.get(), page.get() + SPARSE_PAGE_SIZE, [](uint32_t _index) { return _index == INVALID_INDEX; }))
+                page.reset();
+        }
+        while (!sparsePages.empty() && !sparsePages.back()) sparsePages.pop_back();
     }
 
-    std::vector<Entity> getEntities() const {
+    // Sort the components in place, so that _less(a, b) holds for all a in front of b.
+    // Equal components keep their relative order.
+    // Pools owned by groups are sorted in sections which keep the groups intact, where the other
+    // pools of a group are permuted alongside. Only components whose position changes are moved.
+    // References to components of the permuted pools are invalidated.
+    template <typename Less>
+    void sort(const Less& _less) {
+        sortSections([&](uint32_t _a, uint32_t _b) { return _less(atIndex(_a), atIndex(_b)); });
+    }
+
+    // Sort the components by ascending _key(component), which is evaluated only once per component.
+    template <typename Key>
+    void sortBy(const Key& _key) {
+        std::vector<decltype(_key(std::declval<const Component&>()))> keys;
+        keys.reserve(entities.size());
+        for (size_t i = 0; i < entities.size(); ++i) keys.push_back(_key(atIndex(i)));
+        if (std::is_sorted(keys.begin(), keys.end())) return;
+        sortSections([&](uint32_t _a, uint32_t _b) { return keys[_a] < keys[_b]; });
+    }
+
+    const std::vector<Entity>& getEntities() const {
         return entities;
     }
 
+    // Number of pages which hold components.
+    size_t numPages() const {
+        return (entities.size() + PAGE_SIZE - 1) / PAGE_SIZE;
+    }
+
+    // Components of page _page, which are contiguous and aligned to PAGE_ALIGNMENT.
+    // The first component has the dense index _page * PAGE_SIZE. Cold parts are not included.
+    std::span<Component> getPage(size_t _page) {
+        return {reinterpret_cast<Component*>(pages[_page].get()), std::min(PAGE_SIZE, entities.size() - _page * PAGE_SIZE)};
+    }
+
+    size_t size() const {
+        return entities.size();
+    }
+
+    size_t capacity() const {
+        return pages.size() * PAGE_SIZE;
+    }
+
+    // Memory and occupancy of this pool. The peak is sampled whenever pages are allocated or released.
+    PoolStats stats() const {
+        const size_t numSparsePages = std::count_if(sparsePages.begin(), sparsePages.end(), [](const auto& _page) { return _page != nullptr; });
+        const size_t bytes = allocatedBytes();
+        return {typeName, entities.size(), capacity(), numSparsePages * SPARSE_PAGE_SIZE, bytes, std::max(peakBytes, bytes), numInserts, numErases};
+    }
+
+    void resetChurn() {
+        numInserts = 0;
+        numErases = 0;
+    }
+
    private:
+    friend struct details::GroupData;
+    friend class Registry;
+    template <component_type>
+    friend class ComponentAccess;
+
+    static constexpr uint32_t INVALID_INDEX = ~uint32_t(0);
+
+    struct PageDeleter {
+        void operator()(char* _page) const {
+            ::operator delete[](_page, std::align_val_t{PAGE_ALIGNMENT});
+        }
+    };
+
+    char* element(size_t _index) const {
+        return pages[_index / PAGE_SIZE].get() + (_index % PAGE_SIZE) * componentSize;
+    }
+
+    char* coldElement(size_t _index) const {
+        return coldPages[_index / PAGE_SIZE].get() + (_index % PAGE_SIZE) * coldSize;
+    }
+
+    size_t allocatedBytes() const {
+        const size_t numSparsePages = std::count_if(sparsePages.begin(), sparsePages.end(), [](const auto& _page) { return _page != nullptr; });
+        return pages.size() * PAGE_SIZE * componentSize + pages.capacity() * sizeof(pages[0]) +
+               coldPages.size() * PAGE_SIZE * coldSize + coldPages.capacity() * sizeof(coldPages[0]) +
+               numSparsePages * SPARSE_PAGE_SIZE * sizeof(uint32_t) + sparsePages.capacity() * sizeof(sparsePages[0]) +
+               entities.capacity() * sizeof(Entity) + changed.capacity() * sizeof(uint8_t);
+    }
+
+    void updatePeakBytes() {
+        peakBytes = std::max(peakBytes, allocatedBytes());
+    }
+
+    uint32_t denseIndex(Entity _ent) const {
+        const size_t page = _ent.index() / SPARSE_PAGE_SIZE;
+        if (page >= sparsePages.size() || !sparsePages[page]) return INVALID_INDEX;
+        return sparsePages[page][_ent.index() % SPARSE_PAGE_SIZE];
+    }
+
+    // Slot of _ent in the sparse index. The page has to exist.
+    uint32_t& sparseIndex(Entity _ent) {
+        return sparsePages[_ent.index() / SPARSE_PAGE_SIZE][_ent.index() % SPARSE_PAGE_SIZE];
+    }
+
+    void assureSparsePage(Entity _ent) {
+        const size_t page = _ent.index() / SPARSE_PAGE_SIZE;
+        if (page >= sparsePages.size()) sparsePages.resize(page + 1);
+        if (!sparsePages[page]) {
+            sparsePages[page].reset(new uint32_t[SPARSE_PAGE_SIZE]);
+            std::fill_n(sparsePages[page].get(), SPARSE_PAGE_SIZE, INVALID_INDEX);
+            updatePeakBytes();
+        }
+    }
+
+    void notifyInsert(Entity _ent) {
+        for (details::GroupData* group : groups) group->add(_ent);
+        insertSignal.emit(_ent);
+    }
+
+    // Exchange the positions of two components in the dense array.
+    void swapDense(uint32_t _a, uint32_t _b) {
+        if (_a == _b) return;
+        std::swap_ranges(element(_a), element(_a) + componentSize, element(_b));
+        if (coldSize) std::swap_ranges(coldElement(_a), coldElement(_a) + coldSize, coldElement(_b));
+        std::swap(entities[_a], entities[_b]);
+        std::swap(changed[_a], changed[_b]);
+        sparseIndex(entities[_a]) = _a;
+        sparseIndex(entities[_b]) = _b;
+    }
+
+    // Sort every section of the dense array separately, with _less comparing dense indices.
+    // Entities in [groups[g]->size, groups[g - 1]->size) belong to the groups up to g - 1,
+    // so the section is permuted in all pools of groups[g - 1].
+    template <typename Less>
+    void sortSections(const Less& _less) {
+        std::vector<uint32_t> order;
+        std::vector<std::pair<uint32_t, uint32_t>> swaps;
+        size_t end = entities.size();
+        for (size_t g = 0; g <= groups.size(); ++g) {
+            const size_t begin = g < groups.size() ? groups[g]->size : 0;
+            order.resize(end - begin);
+            std::iota(order.begin(), order.end(), static_cast<uint32_t>(begin));
+            std::stable_sort(order.begin(), order.end(), _less);
+
+            // Decompose the permutation into cycles, position i receives the component at order[i - begin].
+            swaps.clear();
+            for (size_t i = 0; i < order.size(); ++i) {
+                size_t j = i;
+                while (order[j] != begin + i) {
+                    const size_t k = order[j] - begin;
+                    swaps.emplace_back(static_cast<uint32_t>(begin + j), static_cast<uint32_t>(begin + k));
+                    order[j] = static_cast<uint32_t>(begin + j);
+                    j = k;
+                }
+                order[j] = static_cast<uint32_t>(begin + j);
+            }
+
+            if (g == 0) {
+                for (auto [a, b] : swaps) swapDense(a, b);
+            } else {
+                for (ComponentAccess<char>* pool : groups[g - 1]->pools) {
+                    for (auto [a, b] : swaps) pool->swapDense(a, b);
+                }
+            }
+            end = begin;
+        }
+    }
+
+    void construct(Entity _ent, const Component& _comp, const ColdPart& _cold) {
+        new (push(_ent)) Component(_comp);
+        if constexpr (split_component<Component>) new (coldElement(entities.size() - 1)) ColdPart(_cold);
+    }
+
+    // Append _ent and return the uninitialized memory for its component.
+    // The memory of the cold part is left uninitialized as well.
+    char* push(Entity _ent) {
+        if (entities.size() == capacity()) reserve(entities.size() + 1);
+
+        assureSparsePage(_ent);
+        sparseIndex(_ent) = static_cast<uint32_t>(entities.size());
+        entities.push_back(_ent);
+        changed.push_back(1);
+        ++numInserts;
+        if (masks) std::atomic_ref((*masks)[_ent.index()]).fetch_or(maskBit, std::memory_order_relaxed);
+        return element(entities.size() - 1);
+    }
+
     size_t componentSize;
-    std::vector<uint64_t> sparse;
+    std::vector<std::unique_ptr<uint32_t[]>> sparsePages;
     std::vector<Entity> entities;
-    std::vector<char> buffer;
+    // Change flag of every component, in the same order as entities.
+    std::vector<uint8_t> changed;
+    std::vector<std::unique_ptr<char[], PageDeleter>> pages;
+    // Size of the cold part of a split_component, 0 otherwise. coldPages is then empty.
+    size_t coldSize;
+    std::vector<std::unique_ptr<char[], PageDeleter>> coldPages;
+    // Groups owning this pool, from the least to the most restrictive one. Copies do not belong to any group.
+    std::vector<details::GroupData*> groups;
+    // Component masks of the Registry the pool belongs to, updated atomically so that
+    // different pools can be modified concurrently. Not set for copies, standalone pools
+    // and pools beyond MAX_COMPONENTS.
+    std::vector<ComponentMask>* masks = nullptr;
+    ComponentMask maskBit = 0;
+    // Identifies the component type in snapshots, see Registry::save.
+    uint64_t typeHash = 0;
+    std::string_view typeName;
+    // Listeners are not copied.
+    ComponentSignal insertSignal;
+    ComponentSignal eraseSignal;
+    ComponentSignal updateSignal;
+    // Statistics, see stats(). They are not copied.
+    size_t peakBytes = 0;
+    uint64_t numInserts = 0;
+    uint64_t numErases = 0;
+};
+
+inline void details::GroupData::add(Entity _ent) {
+    for (ComponentAccess<char>* pool : pools) {
+        if (!pool->hasEntity(_ent)) return;
+    }
+    if (pools.front()->denseIndex(_ent) < size) return;
+
+    for (ComponentAccess<char>* pool : pools) pool->swapDense(pool->denseIndex(_ent), size);
+    ++size;
+}
+
+inline void details::GroupData::remove(Entity _ent) {
+    const uint32_t index = pools.front()->denseIndex(_ent);
+    if (index >= size) return;
+
+    --size;
+    for (ComponentAccess<char>* pool : pools) pool->swapDense(index, size);
+}
+
+inline void details::GroupData::attach() {
+    for (ComponentAccess<char>* pool : pools) pool->groups.push_back(this);
+
+    const ComponentAccess<char>* smallest = *std::min_element(pools.begin(), pools.end(), [](auto* _a, auto* _b) { return _a->size() < _b->size(); });
+    const std::vector<Entity> candidates = smallest->getEntities();
+    for (Entity ent : candidates) add(ent);
+}
+
+inline void details::GroupData::detach() {
+    for (ComponentAccess<char>* pool : pools) pool->groups.clear();
+    size = 0;
+}
+
+// Set of entities having a tag component, i.e. an empty type. Instead of a pool with
+// sparse index and dense arrays, only one bit per entity index is stored.
+// Tags are requested like const components in queries, e.g. execute<Transform, const Projectile>(...),
+// where they only filter the entities.
+class TagSet {
+   public:
+    void insert(Entity _ent) {
+        const size_t word = _ent.index() / 64;
+        if (word >= words.size()) words.resize(word + 1, 0);
+        const uint64_t bit = uint64_t(1) << (_ent.index() % 64);
+        count += !(words[word] & bit);
+        words[word] |= bit;
+    }
+
+    void erase(Entity _ent) {
+        const size_t word = _ent.index() / 64;
+        if (word >= words.size()) return;
+        const uint64_t bit = uint64_t(1) << (_ent.index() % 64);
+        count -= (words[word] & bit) != 0;
+        words[word] &= ~bit;
+    }
+
+    bool hasEntity(Entity _ent) const {
+        const size_t word = _ent.index() / 64;
+        return word < words.size() && (words[word] >> (_ent.index() % 64) & 1);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    void clear() {
+        words.clear();
+        count = 0;
+    }
+
+    // Bit i of word i / 64 is set if the entity with index i has the tag.
+    const std::vector<uint64_t>& getWords() const {
+        return words;
+    }
+
+   private:
+    friend class Registry;
+
+    std::vector<uint64_t> words;
+    size_t count = 0;
+    // Identifies the tag type in snapshots, see Registry::save.
+    uint64_t typeHash = 0;
+};
+
+// Query filter which only matches entities whose Component was flagged by ComponentAccess::markChanged()
+// or inserted since the last clearChanged(). The action receives the component itself, e.g.
+// execute<Changed<const Transform>, WorldTransform>([](const Transform&, WorldTransform&) {...}).
+template <typename Component>
+struct Changed {};
+
+// Query argument for the cold part of a split_component, e.g.
+// execute<Transform, Cold<const Transform>>([](Transform&, const TransformScale&) {...}).
+// Matches the same entities as Component itself.
+template <typename Component>
+struct Cold {};
+
+namespace details {
+template <typename T>
+struct PoolPointer {
+    using type = ComponentAccess<T>*;
+};
+template <typename T>
+struct PoolPointer<const T> {
+    using type = const ComponentAccess<T>*;
+};
+template <>
+struct PoolPointer<Entity> {
+    using type = std::nullptr_t;
+};
+template <typename T>
+struct PoolPointer<Changed<T>> : PoolPointer<T> {};
+template <typename T>
+struct PoolPointer<Cold<T>> : PoolPointer<T> {};
+template <tag_type T>
+struct PoolPointer<T> {
+    using type = TagSet*;
+};
+template <tag_type T>
+struct PoolPointer<const T> {
+    using type = const TagSet*;
+};
+
+template <typename T>
+constexpr bool is_tag_v = tag_type<std::remove_const_t<T>>;
+
+// Intersection of the TagSets of a query. It is computed a word at a time before iterating,
+// so that every entity is tested against all tags with a single bit test.
+class TagFilter {
+   public:
+    TagFilter() = default;
+    TagFilter(const TagFilter&) = delete;
+    TagFilter& operator=(const TagFilter&) = delete;
+
+    void add(const TagSet& _tags) {
+        if (!words) {
+            words = &_tags.getWords();
+            return;
+        }
+        if (words != &intersection) {
+            intersection = *words;
+            words = &intersection;
+        }
+        const std::vector<uint64_t>& other = _tags.getWords();
+        intersection.resize(std::min(intersection.size(), other.size()));
+        for (size_t i = 0; i < intersection.size(); ++i) intersection[i] &= other[i];
+    }
+
+    bool contains(Entity _ent) const {
+        if (!words) return true;
+        const size_t word = _ent.index() / 64;
+        return word < words->size() && ((*words)[word] >> (_ent.index() % 64) & 1);
+    }
+
+   private:
+    const std::vector<uint64_t>* words = nullptr;
+    std::vector<uint64_t> intersection;
+};
+
+// Type passed to the action for a requested component.
+template <typename T>
+struct QueryArgument {
+    using type = T;
+};
+template <typename T>
+struct QueryArgument<Changed<T>> {
+    using type = T;
+};
+template <typename T>
+struct QueryArgument<Cold<T>> {
+    static_assert(split_component<std::remove_const_t<T>>, "Only split components have a cold part.");
+    using type = std::conditional_t<std::is_const_v<T>, const typename ColdPart<std::remove_const_t<T>>::type,
+                                    typename ColdPart<std::remove_const_t<T>>::type>;
+};
+
+// Component whose pool is accessed for a query argument.
+template <typename T>
+struct QueriedComponent {
+    using type = T;
+};
+template <typename T>
+struct QueriedComponent<Changed<T>> {
+    using type = T;
+};
+template <typename T>
+struct QueriedComponent<Cold<T>> {
+    using type = T;
+};
+}  // namespace details
+
+// Iterable set of entities having all of Components...
+// The pools are resolved once on construction, so iterating performs neither hash lookups nor allocations.
+// Entity can be requested like a component to get the entity itself.
+// Const-qualified components declare read-only access.
+// A View stays valid as long as the Registry it was created from.
+template <typename... Components>
+class View {
+    static_assert(((!std::is_same_v<Components, Entity> && !details::is_tag_v<Components>) || ...),
+                  "A view requires at least one component type which is not a tag.");
+
+   public:
+    View(typename details::PoolPointer<Components>::type... _pools) : pools(_pools...) {}
+
+    // Execute _action(Components&...) for every entity in the view.
+    // Iteration is driven by the smallest pool and runs backwards, so the current entity may be erased.
+    template <typename Action>
+    void each(const Action& _action) const {
+        const std::vector<Entity>& driver = smallestPool();
+        details::TagFilter tags;
+        addTags(tags);
+        for (size_t i = driver.size(); i-- > 0;) {
+            if (i >= driver.size()) continue;
+            Entity entity = driver[i];
+            if (tags.contains(entity) && containsAll<false>(entity, std::index_sequence_for<Components...>{}))
+                invoke(_action, entity, std::index_sequence_for<Components...>{});
+        }
+    }
+
+    // Parallel version of each(). The entities of the driving pool are split into chunks which are
+    // processed by the workers of _threadPool. The action may only modify the non-const components of the
+    // entity it is called for, while const components can be read for any entity.
+    // Structural changes (create, erase, insert) are not allowed.
+    template <typename Action>
+    void eachParallel(const Action& _action, utils::ThreadPool& _threadPool = utils::ThreadPool::global()) const {
+        const std::vector<Entity>& driver = smallestPool();
+        details::TagFilter tags;
+        addTags(tags);
+        _threadPool.parallelFor(driver.size(), _threadPool.chunkSize(driver.size()), [&](size_t _begin, size_t _end) {
+            for (size_t i = _begin; i < _end; ++i) {
+                Entity entity = driver[i];
+                if (tags.contains(entity) && containsAll<false>(entity, std::index_sequence_for<Components...>{}))
+                    invoke(_action, entity, std::index_sequence_for<Components...>{});
+            }
+        });
+    }
+
+    bool contains(Entity _ent) const {
+        return containsAll<true>(_ent, std::index_sequence_for<Components...>{});
+    }
+
+    // Upper bound for the number of entities in the view.
+    size_t sizeHint() const {
+        return smallestPool().size();
+    }
+
+   private:
+    // Tags are only tested if WithTags is set, each() uses a TagFilter instead.
+    template <bool WithTags, size_t... I>
+    bool containsAll(Entity _ent, std::index_sequence<I...>) const {
+        return (matches<Components, WithTags>(std::get<I>(pools), _ent) && ...);
+    }
+
+    template <typename T, bool WithTags, typename Pool>
+    static bool matches(Pool _pool, Entity _ent) {
+        if constexpr (std::is_same_v<T, Entity>)
+            return true;
+        else if constexpr (details::is_tag_v<T>)
+            return !WithTags || _pool->hasEntity(_ent);
+        else if constexpr (utils::is_specialization_v<T, Changed>)
+            return _pool->isChanged(_ent);
+        else
+            return _pool->hasEntity(_ent);
+    }
+
+    template <typename Action, size_t... I>
+    void invoke(const Action& _action, Entity& _ent, std::index_sequence<I...>) const {
+        _action(get<Components>(std::get<I>(pools), _ent)...);
+    }
+
+    // Entities are passed as lvalue so that actions can take them by reference.
+    // Tags have no storage, so all entities share one instance.
+    template <typename T, typename Pool>
+    static typename details::QueryArgument<T>::type& get(Pool _pool, Entity& _ent) {
+        if constexpr (std::is_same_v<T, Entity>)
+            return _ent;
+        else if constexpr (details::is_tag_v<T>) {
+            static std::remove_const_t<T> tag;
+            return tag;
+        } else if constexpr (utils::is_specialization_v<T, Cold>)
+            return *_pool->cold(_ent);
+        else
+            return *_pool->at(_ent);
+    }
+
+    template <typename Pool>
+    static constexpr bool isTagSet = std::is_same_v<std::remove_const_t<std::remove_pointer_t<Pool>>, TagSet>;
+
+    // Tags cannot drive the iteration, since they do not store their entities.
+    const std::vector<Entity>& smallestPool() const {
+        const std::vector<Entity>* smallest = nullptr;
+        auto visit = [&](auto _pool) {
+            if constexpr (!std::is_same_v<decltype(_pool), std::nullptr_t> && !isTagSet<decltype(_pool)>) {
+                if (!smallest || _pool->size() < smallest->size()) smallest = &_pool->getEntities();
+            }
+        };
+        std::apply([&](auto... _pools) { (visit(_pools), ...); }, pools);
+        return *smallest;
+    }
+
+    void addTags(details::TagFilter& _filter) const {
+        auto visit = [&](auto _pool) {
+            if constexpr (isTagSet<decltype(_pool)>) _filter.add(*_pool);
+        };
+        std::apply([&](auto... _pools) { (visit(_pools), ...); }, pools);
+    }
+
+    std::tuple<typename details::PoolPointer<Components>::type...> pools;
+};
+
+// Set of entities having all of Components..., where the pools of the components are owned by the group.
+// Owned pools keep the entities of the group packed in identical order at the front of their dense arrays,
+// so iterating is a lockstep walk over the arrays without any membership tests.
+// Entity can be requested like a component and const-qualified components declare read-only access.
+// A Group stays valid as long as the Registry it was created from.
+template <typename... Components>
+class Group {
+    static_assert(sizeof...(Components) > (utils::contains_type_v<Entity, Components...> ? 1 : 0),
+                  "A group requires at least one component type.");
+    static_assert(!(details::is_tag_v<Components> || ...), "Tags cannot be owned by a group.");
+    static_assert(!(utils::is_specialization_v<Components, Cold> || ...),
+                  "Cold parts cannot be requested from a group, use ComponentAccess::coldAtIndex() instead.");
+
+   public:
+    Group(const details::GroupData* _data, typename details::PoolPointer<Components>::type... _pools)
+        : data(_data), pools(_pools...) {}
+
+    // Execute _action(Components&...) for every entity in the group.
+    // Iteration runs backwards, so the current entity may be erased.
+    template <typename Action>
+    void each(const Action& _action) const {
+        for (size_t i = data->size; i-- > 0;) invoke(_action, i, std::index_sequence_for<Components...>{});
+    }
+
+    // Parallel version of each(), see View::eachParallel for restrictions.
+    template <typename Action>
+    void eachParallel(const Action& _action, utils::ThreadPool& _threadPool = utils::ThreadPool::global()) const {
+        const size_t count = data->size;
+        _threadPool.parallelFor(count, _threadPool.chunkSize(count), [&](size_t _begin, size_t _end) {
+            for (size_t i = _begin; i < _end; ++i) invoke(_action, i, std::index_sequence_for<Components...>{});
+        });
+    }
+
+    size_t size() const {
+        return data->size;
+    }
+
+   private:
+    template <typename Action, size_t... I>
+    void invoke(const Action& _action, size_t _index, std::index_sequence<I...>) const {
+        Entity entity = data->pools.front()->getEntities()[_index];
+        _action(get<Components>(std::get<I>(pools), entity, _index)...);
+    }
+
+    template <typename T, typename Pool>
+    static T& get(Pool _pool, Entity& _ent, size_t _index) {
+        if constexpr (std::is_same_v<T, Entity>)
+            return _ent;
+        else
+            return _pool->atIndex(_index);
+    }
+
+    const details::GroupData* data;
+    std::tuple<typename details::PoolPointer<Components>::type...> pools;
+};
+
+// Set of components with default values from which many entities can be created at once,
+// see Registry::instantiate.
+template <component_type... Components>
+struct Prefab {
+    Prefab(const Components&... _components) : components(_components...) {}
+
+    template <component_type Component>
+    Component& get() {
+        return std::get<Component>(components);
+    }
+
+    std::tuple<Components...> components;
 };
 
 class Registry {
    public:
     Entity create() {
-        uint64_t i;
-
-        if (unusedIds.size() > 0) {
-            i = unusedIds.back();
-            unusedIds.pop_back();
-            flags[i] = true;
-            generations[i]++;
-            return {i};
-        }
-        flags.push_back(true);
-        generations.push_back(1);
-        return {flags.size() - 1};
+        if (hasReserved()) commitReserved();
+        if (freeList != NO_INDEX) {
+            const uint32_t index = freeList;
+            freeList = slots[index].index();
+            reservedHead = freeList;
+            slots[index] = Entity::make(index, slots[index].generation());
+            return slots[index];
+        }
+
+        const Entity ent = Entity::make(static_cast<uint32_t>(slots.size()), 0);
+        slots.push_back(ent);
+        reservedEnd = static_cast<uint32_t>(slots.size());
+        masks->push_back(0);
+        return ent;
     };
 
-    void erase(Entity _ent) {
-        flags[_ent.id] = false;
+    // Create an entity from multiple threads at once, e.g. from executeParallel() or worker jobs.
+    // Only other calls of createConcurrent() may run at the same time, no other modifications of the registry.
+    // The handle is reserved without locking, but the entity is not alive and cannot get components until
+    // commitReserved() is called. Record its components in a CommandBuffer, whose flush() commits it.
+    Entity createConcurrent() {
+        Entity ent;
+        createConcurrent(std::span<Entity>(&ent, 1));
+        return ent;
+    }
 
-        for (auto& element : componentsMap) {
-            ComponentAccess<char>& componentAccess = reinterpret_cast<ComponentAccess<char>&>(element.second);
-            componentAccess.erase(_ent);
+    // Reserve _entities.size() handles at once, see createConcurrent(). A worker which needs many entities
+    // should reserve them in one call, which takes a single compare-and-swap on the free list.
+    void createConcurrent(std::span<Entity> _entities) {
+        // Only pops happen while entities are reserved and no slot is written, so the free list can be
+        // walked without synchronization and a successful exchange cannot suffer from ABA.
+        if (_entities.empty()) return;
+        std::atomic_ref<uint32_t> head(reservedHead);
+        uint32_t first = head.load(std::memory_order_relaxed);
+        size_t numRecycled = 0;
+        for (;;) {
+            // A failed exchange reloads first, so the count of the previous attempt is void.
+            numRecycled = 0;
+            if (first == NO_INDEX) break;
+            uint32_t next = slots[first].index();
+            for (numRecycled = 1; numRecycled < _entities.size() && next != NO_INDEX; ++numRecycled) next = slots[next].index();
+            if (head.compare_exchange_weak(first, next, std::memory_order_relaxed)) break;
         }
 
-        unusedIds.push_back(_ent.id);
+        for (size_t i = 0; i < numRecycled; ++i, first = slots[first].index())
+            _entities[i] = Entity::make(first, slots[first].generation());
+
+        const size_t numNew = _entities.size() - numRecycled;
+        if (numNew == 0) return;
+        const uint32_t begin = std::atomic_ref<uint32_t>(reservedEnd).fetch_add(static_cast<uint32_t>(numNew), std::memory_order_relaxed);
+        ASSERT(begin + numNew < NO_INDEX, "Too many entities.");
+        for (size_t i = 0; i < numNew; ++i) _entities[numRecycled + i] = Entity::make(begin + static_cast<uint32_t>(i), 0);
+    }
+
+    // Make all entities from createConcurrent() alive. Not thread-safe.
+    // create() and erase() commit pending reservations as well.
+    void commitReserved() {
+        for (uint32_t index = freeList; index != reservedHead;) {
+            const uint32_t next = slots[index].index();
+            slots[index] = Entity::make(index, slots[index].generation());
+            index = next;
+        }
+        freeList = reservedHead;
+
+        for (uint32_t index = static_cast<uint32_t>(slots.size()); index < reservedEnd; ++index) slots.push_back(Entity::make(index, 0));
+        masks->resize(slots.size(), 0);
+    }
+
+    // Erase _ent and all its components. Only the pools which hold a component of _ent are accessed.
+    void erase(Entity _ent) {
+        if (hasReserved()) commitReserved();
+        ASSERT(isAlive(_ent), "Erasing an entity which is not alive.");
+        for (ComponentMask mask = (*masks)[_ent.index()]; mask; mask &= mask - 1)
+            pools[maskedPools[std::countr_zero(mask)]]->erase(_ent);
+        for (uint32_t id : unmaskedPools) pools[id]->erase(_ent);
+        for (auto& [type, pool] : unboundPools) pool->erase(_ent);
+        eraseTags(_ent);
+
+        release(_ent.index());
     };
 
+    // Erase multiple entities at once. The components are removed pool by pool.
+    // Entities which are not alive, including duplicates in _entities, are skipped.
+    void erase(std::span<const Entity> _entities) {
+        if (hasReserved()) commitReserved();
+        std::vector<std::vector<Entity>> removals(maskedPools.size());
+        // Pools without mask bits look entities up by index, so they only get the ones which were alive.
+        std::vector<Entity> erased;
+        for (Entity ent : _entities) {
+            if (!isAlive(ent)) continue;
+            erased.push_back(ent);
+            release(ent.index());
+            eraseTags(ent);
+
+            for (ComponentMask mask = (*masks)[ent.index()]; mask; mask &= mask - 1)
+                removals[std::countr_zero(mask)].push_back(ent);
+        }
+
+        for (size_t bit = 0; bit < removals.size(); ++bit) {
+            for (Entity ent : removals[bit]) pools[maskedPools[bit]]->erase(ent);
+        }
+        for (uint32_t id : unmaskedPools) {
+            for (Entity ent : erased) pools[id]->erase(ent);
+        }
+        for (auto& [type, pool] : unboundPools) {
+            for (Entity ent : erased) pool->erase(ent);
+        }
+    }
+
+    // Create _count entities with the components of _prefab. Every pool grows only once and the
+    // components are appended pool by pool. Afterwards, _init(Entity, Components&...) is called for
+    // every new entity to adjust its copy of the defaults, i.e. after the onInsert() signals.
+    // @return The new entities in the order of the _init calls.
+    template <component_type... Components, typename Init>
+    std::vector<Entity> instantiate(const Prefab<Components...>& _prefab, size_t _count, const Init& _init) {
+        std::vector<Entity> entities;
+        entities.reserve(_count);
+        slots.reserve(slots.size() + _count);
+        masks->reserve(masks->size() + _count);
+        for (size_t i = 0; i < _count; ++i) entities.push_back(create());
+
+        std::tuple<ComponentAccess<Components>&...> prefabPools{getComponents<Components>()...};
+        initPrefab(prefabPools, _prefab, entities, _init, std::index_sequence_for<Components...>{});
+        return entities;
+    }
+
+    template <component_type... Components>
+    std::vector<Entity> instantiate(const Prefab<Components...>& _prefab, size_t _count) {
+        return instantiate(_prefab, _count, [](Entity, Components&...) {});
+    }
+
+    // Whether _ent is a current handle, i.e. its index is in use and has the same generation.
+    bool isAlive(Entity _ent) const {
+        return _ent.index() < slots.size() && slots[_ent.index()] == _ent;
+    }
+
     EntityRef getRef(Entity _ent) const {
-        return {_ent, generations[_ent.id]};
+        return _ent;
     };
 
     std::optional<Entity> getEntity(EntityRef _ent) const {
-        if (!flags[_ent.entity.id]) {
-            return {};
-        } else if (_ent.generation != generations[_ent.entity.id]) {
-            return {};
-        } else {
-            return _ent.entity;
-        }
+        if (!isAlive(_ent)) return {};
+        return _ent;
     };
 
+    // Dense id of a component type which is assigned on first use.
+    template <typename Component>
+    static uint32_t componentId() {
+        return static_cast<uint32_t>(utils::TypeIndex::value<std::remove_const_t<Component>>());
+    }
+
     template <component_type Component>
     ComponentAccess<Component>& getComponents() {
-        if (componentsMap.contains(std::type_index(typeid(Component)))) {
-            return reinterpret_cast<ComponentAccess<Component>&>(componentsMap[std::type_index(typeid(Component))]);
-        }
+        static_assert(!tag_type<Component>, "Tags are stored in a TagSet, see getTags().");
+        const uint32_t id = componentId<Component>();
+        if (id >= pools.size()) pools.resize(id + 1);
 
-        ComponentAccess<Component> componentAccess;
-        componentsMap[std::type_index(typeid(Component))] = *reinterpret_cast<ComponentAccess<char>*>(&componentAccess);
-        return reinterpret_cast<ComponentAccess<Component>&>(componentsMap[std::type_index(typeid(Component))]);
+        if (!pools[id]) {
+            ComponentAccess<Component> componentAccess;
+            pools[id] = std::make_unique<ComponentAccess<char>>(std::move(reinterpret_cast<ComponentAccess<char>&>(componentAccess)));
+            if (maskedPools.size() < MAX_COMPONENTS) {
+                pools[id]->masks = masks.get();
+                pools[id]->maskBit = ComponentMask(1) << maskedPools.size();
+                maskedPools.push_back(id);
+            } else
+                unmaskedPools.push_back(id);
+            pools[id]->typeHash = static_cast<uint64_t>(static_type_info::getTypeIndex<Component>());
+            pools[id]->typeName = static_type_info::getTypeName<Component>();
+            if (!unboundPools.empty()) bindPool(id);
+        }
+        return reinterpret_cast<ComponentAccess<Component>&>(*pools[id]);
     }
 
     template <component_type Component>
     const ComponentAccess<Component>& getComponents() const {
-        return reinterpret_cast<const ComponentAccess<Component>&>(componentsMap.find(std::type_index(typeid(Component)))->second);
+        return reinterpret_cast<const ComponentAccess<Component>&>(*pools[componentId<Component>()]);
+    }
+
+    // Sort the pool of Component in place, see ComponentAccess::sort.
+    template <component_type Component, typename Less>
+    void sort(const Less& _less) {
+        getComponents<Component>().sort(_less);
+    }
+
+    // Set of entities having the tag Tag.
+    template <tag_type Tag>
+    TagSet& getTags() {
+        const uint32_t id = componentId<Tag>();
+        if (id >= tagSets.size()) tagSets.resize(id + 1);
+
+        if (!tagSets[id]) {
+            tagSets[id] = std::make_unique<TagSet>();
+            tagSets[id]->typeHash = static_cast<uint64_t>(static_type_info::getTypeIndex<Tag>());
+            if (!unboundTags.empty()) bindTags(id);
+        }
+        return *tagSets[id];
+    }
+
+    template <tag_type Tag>
+    const TagSet& getTags() const {
+        return *tagSets[componentId<Tag>()];
+    }
+
+    // Create a view over all entities having the components Components...
+    // Missing pools are created, so the view remains valid when components are added later on.
+    template <typename... Components>
+    View<Components...> view() {
+        return View<Components...>(getPool<Components>()...);
     }
 
     // Execute an Action on all entities having the components
@@ -167,53 +1263,171 @@ class Registry {
     // the first parameter is of type Entity.
     template <typename... Components, typename Action>
     void execute(const Action& _action) {
-        std::vector<std::type_index> componentTypes = {std::type_index(typeid(Components))...};
+        view<Components...>().each(_action);
+    }
+
+    // Execute an Action on all entities having Components... using the worker threads.
+    // Components which are only read should be const-qualified, e.g.
+    // executeParallel<const MeshCollider, Transform>(...). See View::eachParallel for restrictions.
+    template <typename... Components, typename Action>
+    void executeParallel(const Action& _action) {
+        view<Components...>().eachParallel(_action);
+    }
+
+    // Create or retrieve the owning group of Components..., see Group.
+    // Several groups may own the same pool only if their component sets are nested,
+    // e.g. group<Transform, MeshRender>() and group<Transform, MeshRender, Light>().
+    template <typename... Components>
+    Group<Components...> group() {
+        std::vector<uint32_t> types;
+        ((std::is_same_v<Components, Entity> ? void() : types.push_back(componentId<Components>())), ...);
+        std::sort(types.begin(), types.end());
+
+        auto poolPointers = std::make_tuple(getPool<Components>()...);
+        const details::GroupData* data = findGroup(types);
+        if (!data) data = createGroup(std::move(types));
+
+        return std::apply([&](auto... _pools) { return Group<Components...>(data, _pools...); }, poolPointers);
+    }
+
+    // Write all entities and components to a binary file.
+    // Component types are identified by their static_type_info hash, so snapshots can only be
+    // loaded by builds of the same compiler. Entities from createConcurrent() are only included once committed.
+    // @return Whether the file could be written.
+    bool save(const std::string& _fileName) const;
+
+    // Replace the content of the registry with a snapshot created by save().
+    // The file is memory mapped and all data is copied in bulk, without processing single entities.
+    // Components of types which have not been used yet are kept until the pool is created.
+    // @return Whether the snapshot could be read. The registry is not changed otherwise.
+    bool load(const std::string& _fileName);
 
-        size_t startIndex = 0;
+    // Memory and occupancy of all pools, including those of a loaded snapshot which were not bound yet.
+    std::vector<PoolStats> stats() const;
 
-        if (componentTypes[0] == std::type_index(typeid(Entity))) {
-            startIndex = 1;
+    // Write stats() to the log, one line per pool.
+    void logStats() const;
+
+    // stats() as a JSON array with one object per pool.
+    nlohmann::json statsJson() const;
+
+    // Reset the insert and erase counters of all pools, e.g. once per frame.
+    void resetChurn() {
+        for (auto& pool : pools) {
+            if (pool) pool->resetChurn();
         }
+        for (auto& [type, pool] : unboundPools) pool->resetChurn();
+    }
 
-        if (!componentsMap.contains(componentTypes[startIndex])) return;
-        std::vector<Entity> entities = componentsMap[componentTypes[startIndex]].getEntities();
+    // Reset the change flags of all components, see Changed.
+    void clearChanged() {
+        for (auto& pool : pools) {
+            if (pool) pool->clearChanged();
+        }
+    }
 
-        for (size_t i = startIndex + 1; i < componentTypes.size(); i++) {
-            if (!componentsMap.contains(componentTypes[i])) return;
-            auto it = std::remove_if(entities.begin(), entities.end(), [&](Entity ent) {
-                return !componentsMap.at(componentTypes[i]).hasEntity(ent);
-            });
-            entities.erase(it, entities.end());
+   private:
+    template <typename Component>
+    typename details::PoolPointer<Component>::type getPool() {
+        if constexpr (std::is_same_v<Component, Entity>)
+            return nullptr;
+        else if constexpr (utils::is_specialization_v<Component, Changed> || utils::is_specialization_v<Component, Cold>)
+            return getPool<typename details::QueriedComponent<Component>::type>();
+        else if constexpr (details::is_tag_v<Component>)
+            return &getTags<std::remove_const_t<Component>>();
+        else
+            return &getComponents<std::remove_const_t<Component>>();
+    }
+
+    details::GroupData* findGroup(const std::vector<uint32_t>& _types) {
+        for (auto& group : groups) {
+            if (group->types == _types) return group.get();
         }
+        return nullptr;
+    }
 
-        for (Entity entity : entities) {
-            helper<Components...>(entity, _action, std::tie());
+    // The owned pools have to exist already.
+    details::GroupData* createGroup(std::vector<uint32_t> _types) {
+        for (auto& group : groups) {
+            const bool shared = std::find_first_of(_types.begin(), _types.end(), group->types.begin(), group->types.end()) != _types.end();
+            ASSERT(!shared || std::includes(_types.begin(), _types.end(), group->types.begin(), group->types.end()) ||
+                       std::includes(group->types.begin(), group->types.end(), _types.begin(), _types.end()),
+                   "Groups which own the same component have to be nested.");
         }
+
+        auto group = std::make_unique<details::GroupData>();
+        group->types = std::move(_types);
+        for (uint32_t type : group->types) group->pools.push_back(pools[type].get());
+        details::GroupData* data = group.get();
+        groups.push_back(std::move(group));
+
+        // Nested groups are built from the least to the most restrictive one,
+        // so that each group is a prefix of the groups it is nested in.
+        std::stable_sort(groups.begin(), groups.end(), [](const auto& _a, const auto& _b) { return _a->types.size() < _b->types.size(); });
+        for (auto& g : groups) g->detach();
+        for (auto& g : groups) g->attach();
+        return data;
     }
 
-    template <typename Component, typename... Rest, typename Action, typename Args>
-    void helper(Entity entity, const Action& action, Args args) {
-        if constexpr (std::is_same<Entity, Component>::value) {
-            auto allArgs = std::tuple_cat(args, std::tie(entity));
-            if constexpr (sizeof...(Rest) > 0)
-                helper<Rest...>(entity, action, allArgs);
-            else
-                std::apply(action, allArgs);
+    template <typename Pools, typename PrefabType, typename Init, size_t... I>
+    static void initPrefab(Pools& _pools, const PrefabType& _prefab, const std::vector<Entity>& _entities, const Init& _init,
+                           std::index_sequence<I...>) {
+        const size_t offsets[] = {std::get<I>(_pools).size()...};
+        (std::get<I>(_pools).insertRange(_entities, std::get<I>(_prefab.components)), ...);
 
+        // Without groups the new components are at the end of the dense arrays in the same order as _entities.
+        if ((std::get<I>(_pools).groups.empty() && ...)) {
+            for (size_t i = 0; i < _entities.size(); ++i) _init(_entities[i], std::get<I>(_pools).atIndex(offsets[I] + i)...);
         } else {
-            Component& component = getComponents<Component>()[entity];
-            auto allArgs = std::tuple_cat(args, std::tie(component));
-            if constexpr (sizeof...(Rest) > 0)
-                helper<Rest...>(entity, action, allArgs);
-            else
-                std::apply(action, allArgs);
+            for (Entity ent : _entities) _init(ent, *std::get<I>(_pools).at(ent)...);
         }
     }
 
-   private:
-    std::unordered_map<std::type_index, ComponentAccess<char>> componentsMap;
+    // Put _index at the front of the free list and increment its generation.
+    void release(uint32_t _index) {
+        slots[_index] = Entity::make(freeList, slots[_index].generation() + 1);
+        freeList = _index;
+        reservedHead = freeList;
+    }
+
+    bool hasReserved() const {
+        return reservedHead != freeList || reservedEnd != slots.size();
+    }
+
+    void eraseTags(Entity _ent) {
+        for (auto& tags : tagSets) {
+            if (tags) tags->erase(_ent);
+        }
+        for (auto& [type, tags] : unboundTags) tags.erase(_ent);
+    }
+
+    // Move the pool for componentId _id out of unboundPools if the last snapshot contained one.
+    void bindPool(uint32_t _id);
+    // Same as bindPool() for the TagSet of componentId _id.
+    void bindTags(uint32_t _id);
+
+    // Pools indexed by componentId(). They are allocated individually, so views can keep pointers to them.
+    std::vector<std::unique_ptr<ComponentAccess<char>>> pools;
+    // Pools loaded from a snapshot whose component type has not been used yet, by type hash.
+    std::unordered_map<uint64_t, std::unique_ptr<ComponentAccess<char>>> unboundPools;
+    // TagSets indexed by componentId(), allocated individually like the pools.
+    std::vector<std::unique_ptr<TagSet>> tagSets;
+    std::unordered_map<uint64_t, TagSet> unboundTags;
+    std::vector<std::unique_ptr<details::GroupData>> groups;
+    // Components of every entity by entity index. Allocated separately, so pools can keep a pointer to it.
+    std::unique_ptr<std::vector<ComponentMask>> masks = std::make_unique<std::vector<ComponentMask>>();
+    // componentId() of the pool of every mask bit and of the pools which got no bit.
+    std::vector<uint32_t> maskedPools;
+    std::vector<uint32_t> unmaskedPools;
+
+    static constexpr uint32_t NO_INDEX = ~uint32_t(0);
 
-    std::vector<bool> flags;
-    std::vector<uint64_t> unusedIds;
-    std::vector<uint64_t> generations;
+    // Current handle of every index. Slots of erased entities instead hold the next index of
+    // the free list together with the generation the index gets when it is reused.
+    std::vector<Entity> slots;
+    uint32_t freeList = NO_INDEX;
+    // Head of the free list and end of the slots after the reservations of createConcurrent().
+    // Equal to freeList and slots.size() when nothing is reserved.
+    uint32_t reservedHead = NO_INDEX;
+    uint32_t reservedEnd = 0;
 };
\ No newline at end of file
@@ -12,6 +12,8 @@ class GameState {
     virtual void onPause() = 0;
     virtual void onResume() = 0;
     virtual bool isFinished() = 0;
+    // Whether draw() only reads data published by the previous update(), so that both can run concurrently.
+    virtual bool drawsConcurrently() { return false; }
 
     virtual void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods) = 0; /* purely abstract function */
     virtual void mouseButtonCallback(GLFWwindow *window, int button, int action, int mods) = 0;
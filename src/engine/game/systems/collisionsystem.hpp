@@ -1,9 +1,12 @@
 #pragma once
 
+#include <engine/game/commandbuffer.hpp>
 #include <engine/game/components.hpp>
 #include <engine/game/registry.hpp>
+#include <engine/game/systems/transformsystem.hpp>
 #include <engine/math/convexhull.hpp>
 #include <engine/utils/containers/octree.hpp>
+#include <engine/utils/threadpool.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <set>
 
@@ -17,38 +20,64 @@ struct CollisionInfo {
     bool calculated = true;
 };
 
+// Mesh collisions keep the hull vertices of the MeshColliders of one Registry in world space.
+// The Registry has to outlive the system.
 class CollisionSystem {
    public:
     static inline const float restitution = 0.85f;  // disperse some kinectic energy
 
-    static void updateMeshCollsions(Registry& registry) {
-        std::unordered_map<uint64_t, CollisionInfo> collisions;
-        std::unordered_map<uint64_t, std::vector<glm::vec3>> transformedVertices;
+    explicit CollisionSystem(Registry& _registry) : boundRegistry(_registry) {
+        boundRegistry.getComponents<MeshCollider>().onErase().connect(ComponentListener::bind<&CollisionSystem::eraseTransformedVertices>(*this));
+    }
+
+    ~CollisionSystem() {
+        boundRegistry.getComponents<MeshCollider>().onErase().disconnect(ComponentListener::bind<&CollisionSystem::eraseTransformedVertices>(*this));
+    }
 
-        registry.execute<Entity, MeshCollider, Transform>([&](const Entity& entity, const MeshCollider& collider, const Transform& transform) {
-            glm::mat4 transformMatrix = glm::translate(glm::mat4(1.0f), transform.position);
-            transformMatrix = glm::rotate(transformMatrix, transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
-            transformMatrix = glm::rotate(transformMatrix, transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-            transformMatrix = glm::rotate(transformMatrix, transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
-            transformMatrix = glm::scale(transformMatrix, transform.scale);
+    CollisionSystem(const CollisionSystem&) = delete;
+    CollisionSystem& operator=(const CollisionSystem&) = delete;
+
+    void updateMeshCollsions(Registry& registry) {
+        std::unordered_map<uint64_t, CollisionInfo> collisions;
+        auto& transforms = registry.getComponents<Transform>();
+        const auto& colliders = registry.getComponents<MeshCollider>();
+
+        // Only hulls of entities whose Transform or MeshCollider changed since the last clearChanged() are
+        // transformed again. Inserting a MeshCollider flags it as changed, so new colliders always get their hull.
+        // Create all entries up front, so that the parallel pass below only writes to existing elements.
+        std::vector<Entity> outdated;
+        registry.execute<Entity, const MeshCollider, Changed<const Transform>>([&](const Entity& entity, const MeshCollider&, const Transform&) {
+            transformedVertices[entity.index()];
+            outdated.push_back(entity);
+        });
+        registry.execute<Entity, Changed<const MeshCollider>, const Transform>([&](const Entity& entity, const MeshCollider&, const Transform&) {
+            if (transforms.isChanged(entity)) return;
+            transformedVertices[entity.index()];
+            outdated.push_back(entity);
+        });
 
-            transformedVertices[entity.id] = getTransformedVertices(collider.mesh, transformMatrix);
+        utils::ThreadPool& threadPool = utils::ThreadPool::global();
+        threadPool.parallelFor(outdated.size(), threadPool.chunkSize(outdated.size()), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Entity entity = outdated[i];
+                transformedVertices.at(entity.index()) =
+                    getTransformedVertices(colliders.at(entity)->mesh, TransformSystem::getModelMatrix(*transforms.at(entity), *transforms.cold(entity)));
+            }
         });
 
         registry.execute<Entity, MeshCollider, Transform>([&](const Entity& entity, const MeshCollider& collider, Transform& transform) {
-            const auto& colliders = registry.getComponents<MeshCollider>();
             const std::vector<Entity>& otherEntities = colliders.getEntities();
 
             for (const Entity& otherEntity : otherEntities) {
                 if (otherEntity == entity) continue;
                 bool collision = false;
-                for (const glm::vec3& vertex : transformedVertices[otherEntity.id]) {
+                for (const glm::vec3& vertex : transformedVertices[otherEntity.index()]) {
                     collision = true;
                     for (const ConvexMesh::Face& face : collider.mesh->faces) {
-                        glm::vec3 faceNormal = ConvexHull::getFaceNormal({transformedVertices[entity.id][face.vertexIndices[0]],
-                                                                          transformedVertices[entity.id][face.vertexIndices[1]],
-                                                                          transformedVertices[entity.id][face.vertexIndices[2]]});
-                        float distance = glm::dot(faceNormal, (vertex - transformedVertices[entity.id][face.vertexIndices[0]]));
+                        glm::vec3 faceNormal = ConvexHull::getFaceNormal({transformedVertices[entity.index()][face.vertexIndices[0]],
+                                                                          transformedVertices[entity.index()][face.vertexIndices[1]],
+                                                                          transformedVertices[entity.index()][face.vertexIndices[2]]});
+                        float distance = glm::dot(faceNormal, (vertex - transformedVertices[entity.index()][face.vertexIndices[0]]));
                         if (distance > 0) {
                             collision = false;
                             break;
@@ -64,30 +93,33 @@ class CollisionSystem {
             }
         });
 
+        // Entities moved by the resolution below. Their change flags are cleared before the next update
+        // reads them, so their hulls are transformed again right after the resolution.
+        std::vector<Entity> resolved;
         for (auto& entityCollision : collisions) {
             if (entityCollision.second.calculated) continue;
 
             CollisionInfo& collision = entityCollision.second;
 
             ConvexMesh* mesh = registry.getComponents<MeshCollider>().at(collision.entityB)->mesh;
-            Transform* transformA = registry.getComponents<Transform>().at(collision.entityA);
-            Transform* transformB = registry.getComponents<Transform>().at(collision.entityB);
+            Transform* transformA = transforms.at(collision.entityA);
+            Transform* transformB = transforms.at(collision.entityB);
             PhysicsObject* physicsObjectA = registry.getComponents<PhysicsObject>().at(collision.entityA);
             PhysicsObject* physicsObjectB = registry.getComponents<PhysicsObject>().at(collision.entityB);
 
             for (const ConvexMesh::Face& face : mesh->faces) {
-                glm::vec3 faceNormal = -ConvexHull::getFaceNormal({transformedVertices[collision.entityB.id][face.vertexIndices[0]],
-                                                                   transformedVertices[collision.entityB.id][face.vertexIndices[1]],
-                                                                   transformedVertices[collision.entityB.id][face.vertexIndices[2]]});
+                glm::vec3 faceNormal = -ConvexHull::getFaceNormal({transformedVertices[collision.entityB.index()][face.vertexIndices[0]],
+                                                                   transformedVertices[collision.entityB.index()][face.vertexIndices[1]],
+                                                                   transformedVertices[collision.entityB.index()][face.vertexIndices[2]]});
 
                 auto intersection = intersectionLinePlane(collision.point, transformA->velocity,
-                                                          transformedVertices[collision.entityB.id][face.vertexIndices[0]],
+                                                          transformedVertices[collision.entityB.index()][face.vertexIndices[0]],
                                                           -faceNormal);
                 if (intersection.has_value() && intersection.value().second > 0 &&
                     pointInTriangle(intersection.value().first,
-                                    transformedVertices[collision.entityB.id][face.vertexIndices[0]],
-                                    transformedVertices[collision.entityB.id][face.vertexIndices[1]],
-                                    transformedVertices[collision.entityB.id][face.vertexIndices[2]])) {
+                                    transformedVertices[collision.entityB.index()][face.vertexIndices[0]],
+                                    transformedVertices[collision.entityB.index()][face.vertexIndices[1]],
+                                    transformedVertices[collision.entityB.index()][face.vertexIndices[2]])) {
                     // Resolve Collision with Impulse method
                     float totalMass = 1.0f / physicsObjectA->mass + 1.0f / physicsObjectB->mass;
                     glm::vec3 point = intersection.value().first;
@@ -127,6 +159,10 @@ class CollisionSystem {
 
                     transformA->angularVelocity += transformedInertiaTensorA * glm::cross(relativeA, -impulse);
                     transformB->angularVelocity += transformedInertiaTensorB * glm::cross(relativeB, impulse);
+                    transforms.markChanged(collision.entityA);
+                    transforms.markChanged(collision.entityB);
+                    resolved.push_back(collision.entityA);
+                    resolved.push_back(collision.entityB);
 
                     break;
                 }
@@ -134,6 +170,11 @@ class CollisionSystem {
             if (collisions.find(collision.entityA.id) != collisions.end())
                 collisions[collision.entityA.id].calculated = true;
         }
+
+        for (Entity entity : resolved) {
+            transformedVertices[entity.index()] =
+                getTransformedVertices(colliders.at(entity)->mesh, TransformSystem::getModelMatrix(*transforms.at(entity), *transforms.cold(entity)));
+        }
     }
 
     static glm::mat3 getTransformedInertiaTensor(const glm::mat3& inertiaTensor, const Transform& transform) {
@@ -193,41 +234,48 @@ class CollisionSystem {
     static void updateAABBCollisions(Registry& registry) {
         utils::SparseOctree<Entity, 3, float> octree;
 
-        registry.execute<Entity, AABBCollider, Transform>([&](Entity& entity, AABBCollider& collider, Transform& transform) {
+        registry.group<Entity, AABBCollider, const Transform>().each([&](Entity& entity, AABBCollider& collider, const Transform& transform) {
             collider.aabb.min += transform.velocity;
             collider.aabb.max += transform.velocity;
             octree.insert(collider.aabb, entity);
         });
 
-        std::vector<Entity> toRemove;
+        CommandBuffer commands;
 
-        registry.execute<Entity, AABBCollider>([&](const Entity& entity, const AABBCollider& collider) {
-            if (collider.colliderType == ColliderType::Projectile) {
-                utils::SparseOctree<Entity, 3, float>::AABBQuery query(collider.aabb);
-                octree.traverse(query);
+        const TagSet& projectiles = registry.getTags<Projectile>();
+        registry.execute<Entity, const AABBCollider, const Projectile>([&](const Entity& entity, const AABBCollider& collider, const Projectile&) {
+            utils::SparseOctree<Entity, 3, float>::AABBQuery query(collider.aabb);
+            octree.traverse(query);
 
-                std::vector<Entity> hits;
-                std::set<Entity> s(query.hits.begin(), query.hits.end());
-                hits.assign(s.begin(), s.end());
+            std::vector<Entity> hits;
+            std::set<Entity> s(query.hits.begin(), query.hits.end());
+            hits.assign(s.begin(), s.end());
 
-                auto& colliders = registry.getComponents<AABBCollider>();
+            auto& colliders = registry.getComponents<AABBCollider>();
 
-                for (Entity& hit : hits) {
-                    if (entity == hit || colliders.at(hit)->colliderType == ColliderType::Projectile) continue;
+            for (Entity& hit : hits) {
+                if (entity == hit || projectiles.hasEntity(hit)) continue;
 
-                    octree.remove(colliders.at(hit)->aabb, hit);
-                    toRemove.push_back(hit);
-                }
+                octree.remove(colliders.at(hit)->aabb, hit);
+                commands.erase(hit);
             }
         });
 
-        for (auto& entity : toRemove) {
-            registry.erase(entity);
-        }
+        commands.flush(registry);
     }
 
    private:
     static std::unordered_map<utils::MeshData::Handle, ConvexMesh> convexHulls;
+    // Registry whose MeshCollider::onErase() is connected to the system.
+    Registry& boundRegistry;
+    // Hull vertices in world space by entity index. Kept across frames and only updated for changed transforms
+    // and colliders and after a collision moved the entity.
+    std::unordered_map<uint64_t, std::vector<glm::vec3>> transformedVertices;
+
+    // Connected to MeshCollider::onErase(), so the cache does not keep vertices of erased colliders.
+    void eraseTransformedVertices(Entity entity) {
+        transformedVertices.erase(entity.index());
+    }
 
     static std::vector<glm::vec3> getTransformedVertices(const ConvexMesh* mesh, const glm::mat4 transformMatrix) {
         std::vector<glm::vec3> positions = mesh->positions;
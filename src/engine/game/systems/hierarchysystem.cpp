@@ -0,0 +1,123 @@
+#include <engine/game/systems/hierarchysystem.hpp>
+#include <engine/game/systems/transformsystem.hpp>
+#include <engine/utils/threadpool.hpp>
+#include <spdlog/spdlog.h>
+
+#include <unordered_map>
+
+void HierarchySystem::updateWorldMatrices(Registry& registry) {
+    auto& transforms = registry.getComponents<Transform>();
+    auto& worldTransforms = registry.getComponents<WorldTransform>();
+    const auto& parents = registry.getComponents<Parent>();
+
+    registry.execute<Entity, Changed<const Transform>>([&](Entity& entity, const Transform&) {
+        worldTransforms.insert(entity, {});
+    });
+
+    bool structureChanged = parents.size() != numParents;
+    registry.execute<Changed<const Parent>>([&](const Parent&) { structureChanged = true; });
+    if (structureChanged) rebuild(registry);
+
+    // Roots first, their WorldTransform is flagged so that the children below are recomputed as well.
+    registry.executeParallel<Entity, Changed<const Transform>, Cold<const Transform>, WorldTransform>(
+        [&](Entity& entity, const Transform& transform, const TransformScale& scale, WorldTransform& worldTransform) {
+            if (parents.hasEntity(entity)) return;
+            worldTransform.matrix = TransformSystem::getModelMatrix(transform, scale);
+            worldTransforms.markChanged(entity);
+        });
+
+    // Entities whose Parent was removed are roots now, even if their Transform did not change.
+    for (Entity entity : detached) {
+        const Transform* transform = transforms.at(entity);
+        WorldTransform* worldTransform = worldTransforms.at(entity);
+        if (!transform || !worldTransform || parents.hasEntity(entity)) continue;
+        worldTransform->matrix = TransformSystem::getModelMatrix(*transform, *transforms.cold(entity));
+        worldTransforms.markChanged(entity);
+    }
+    detached.clear();
+
+    // Every node only reads the WorldTransform of its parent from a previous level.
+    utils::ThreadPool& threadPool = utils::ThreadPool::global();
+    for (size_t level = 0; level + 1 < levels.size(); ++level) {
+        const size_t first = levels[level];
+        const size_t count = levels[level + 1] - first;
+        threadPool.parallelFor(count, threadPool.chunkSize(count), [&](size_t begin, size_t end) {
+            for (size_t i = first + begin; i < first + end; ++i) {
+                const Node& node = nodes[i];
+                const Transform* transform = transforms.at(node.entity);
+                WorldTransform* worldTransform = worldTransforms.at(node.entity);
+                if (!transform || !worldTransform) continue;
+
+                // Entities whose parent was erased are recomputed as roots until their Parent is removed.
+                const WorldTransform* parentTransform = registry.isAlive(node.parent) ? worldTransforms.at(node.parent) : nullptr;
+                if (parentTransform && !worldTransforms.isChanged(node.parent) && !transforms.isChanged(node.entity) &&
+                    !parents.isChanged(node.entity))
+                    continue;
+
+                const glm::mat4 local = TransformSystem::getModelMatrix(*transform, *transforms.cold(node.entity));
+                worldTransform->matrix = parentTransform ? parentTransform->matrix * local : local;
+                worldTransforms.markChanged(node.entity);
+            }
+        });
+    }
+}
+
+void HierarchySystem::rebuild(Registry& registry) {
+    const auto& parents = registry.getComponents<Parent>();
+    numParents = parents.size();
+    for (const Node& node : nodes) {
+        if (!parents.hasEntity(node.entity)) detached.push_back(node.entity);
+    }
+
+    // Depth of every entity with a Parent by entity index, roots have depth 0.
+    // Entities in or below a parent cycle get NO_DEPTH and are left out.
+    constexpr uint32_t NO_DEPTH = ~uint32_t(0);
+    std::unordered_map<uint32_t, uint32_t> depths;
+    std::vector<Entity> path;
+    std::vector<uint32_t> levelSizes;
+    size_t numCyclic = 0;
+    registry.execute<Entity, const Parent>([&](const Entity& entity, const Parent&) {
+        // Walk up until a root or an entity with known depth is reached.
+        uint32_t depth = 0;
+        path.clear();
+        for (Entity current = entity;;) {
+            auto it = depths.find(current.index());
+            if (it != depths.end()) {
+                depth = it->second;
+                break;
+            }
+            const Parent* parent = parents.at(current);
+            if (!parent) break;
+            path.push_back(current);
+            // A longer path than there are parents has to revisit an entity.
+            if (path.size() > parents.size()) {
+                depth = NO_DEPTH;
+                break;
+            }
+            if (!registry.isAlive(parent->entity)) break;
+            current = parent->entity;
+        }
+
+        if (depth == NO_DEPTH) {
+            for (Entity ent : path) numCyclic += depths.emplace(ent.index(), NO_DEPTH).second;
+            return;
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            depths[it->index()] = ++depth;
+            if (depth > levelSizes.size()) levelSizes.push_back(0);
+            ++levelSizes[depth - 1];
+        }
+    });
+    if (numCyclic) spdlog::error("[game] {} entities are part of or below a Parent cycle, their world matrices are not updated.", numCyclic);
+
+    levels.assign(1, 0);
+    for (uint32_t size : levelSizes) levels.push_back(levels.back() + size);
+
+    // Counting sort by depth, every level stays in the order of the Parent pool.
+    std::vector<size_t> next(levels.begin(), levels.end() - 1);
+    nodes.resize(levels.back());
+    registry.execute<Entity, const Parent>([&](const Entity& entity, const Parent& parent) {
+        const uint32_t depth = depths[entity.index()];
+        if (depth != NO_DEPTH) nodes[next[depth - 1]++] = {entity, parent.entity};
+    });
+}
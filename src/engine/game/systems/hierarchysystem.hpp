@@ -0,0 +1,39 @@
+#pragma once
+
+#include <engine/game/components.hpp>
+#include <engine/game/registry.hpp>
+
+#include <vector>
+
+// World matrices for entity hierarchies built with the Parent component.
+// Entities with a Parent are kept sorted by their depth, so that each level only depends on the
+// levels before it and is computed in parallel as one contiguous batch. Subtrees whose Transforms
+// did not change are skipped.
+class HierarchySystem {
+   public:
+    // Recompute the WorldTransform of all entities whose Transform or Parent changed or whose parent got
+    // a new WorldTransform. Recomputed WorldTransforms are flagged as changed.
+    // Missing WorldTransforms are inserted, so the system has to be scheduled as exclusive.
+    void updateWorldMatrices(Registry& registry);
+
+    // Number of levels below the root entities, as of the last update.
+    size_t numLevels() const { return levels.empty() ? 0 : levels.size() - 1; }
+
+   private:
+    struct Node {
+        Entity entity;
+        Entity parent;
+    };
+
+    // Sort all entities with a Parent by depth. Parents which are not alive make an entity a root.
+    // Entities in a Parent cycle and their descendants are skipped with an error.
+    void rebuild(Registry& registry);
+
+    std::vector<Node> nodes;
+    // Size of the Parent pool at the last rebuild.
+    size_t numParents = 0;
+    // Entities which lost their Parent since the last update.
+    std::vector<Entity> detached;
+    // Begin of every level in nodes, followed by nodes.size().
+    std::vector<size_t> levels;
+};
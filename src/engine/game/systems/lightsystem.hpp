@@ -7,22 +7,42 @@
 
 class LightSystem {
    public:
+    struct LightData {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> colors;
+    };
+
     static void updateLights(Registry& registry, graphics::Program& program) {
-        std::vector<glm::vec3> lightPos;
-        std::vector<glm::vec3> lightCol;
+        LightData lights;
+        gatherLights(registry, lights);
+        uploadLights(lights, program);
+    };
 
-        registry.execute<Light>([&](Light& light) {
-            lightPos.push_back(light.position);
-            lightCol.push_back(light.color);
-        });
+    // Collect all lights. Only reads the registry, so it can run concurrently with other systems.
+    static void gatherLights(Registry& registry, LightData& lights) {
+        gatherLights(registry.getComponents<Light>(), lights);
+    }
 
-        program.setUniform(1, (int)lightPos.size(), lightPos.data());
-        program.setUniform(2, (int)lightCol.size(), lightCol.data());
-    };
+    // Collect all lights of a pool, e.g. from a RenderSnapshot::Frame.
+    static void gatherLights(const ComponentAccess<Light>& pool, LightData& lights) {
+        lights.positions.clear();
+        lights.colors.clear();
+
+        for (size_t i = 0; i < pool.size(); ++i) {
+            lights.positions.push_back(pool.atIndex(i).position);
+            lights.colors.push_back(pool.atIndex(i).color);
+        }
+    }
+
+    // Has to be called from the thread owning the OpenGL context.
+    static void uploadLights(const LightData& lights, graphics::Program& program) {
+        program.setUniform(1, (int)lights.positions.size(), lights.positions.data());
+        program.setUniform(2, (int)lights.colors.size(), lights.colors.data());
+    }
 
     static void addLights(Registry& registry, const std::vector<Light>& lights) {
         for (auto& light : lights) {
             registry.getComponents<Light>().insert(registry.create(), light);
         }
     }
-};
\ No newline at end of file
+};
@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <engine/game/components.hpp>
+#include <engine/game/framesnapshot.hpp>
 #include <engine/game/registry.hpp>
 #include <engine/graphics/core/texture.hpp>
 #include <engine/graphics/renderer/mesh.hpp>
@@ -10,19 +11,18 @@
 
 using namespace graphics;
 
+// Components read while drawing. The game states publish them at the end of each update,
+// so that drawing can run concurrently with the next update.
+using RenderSnapshot = FrameSnapshot<WorldTransform, MeshRender, Light>;
+
 class RenderSystem {
    public:
-    static void draw(Registry& registry, MeshRenderer& meshRenderer, Camera camera, glm::vec3& cameraPosition) {
+    static void draw(const RenderSnapshot::Frame& frame, MeshRenderer& meshRenderer, Camera camera, glm::vec3& cameraPosition) {
         meshRenderer.clear();
 
-        registry.execute<Transform, MeshRender>([&](Transform& transform, MeshRender& meshRender) {
-            glm::mat4 newTransform = glm::translate(glm::mat4(1.0f), transform.position);
-            newTransform = glm::rotate(newTransform, transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
-            newTransform = glm::rotate(newTransform, transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-            newTransform = glm::rotate(newTransform, transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
-            newTransform = glm::scale(newTransform, transform.scale);
-
-            meshRenderer.draw(*meshRender.mesh, *const_cast<Texture2D*>(meshRender.texture), newTransform);
+        // World matrices are kept up to date by HierarchySystem::updateWorldMatrices.
+        frame.view<const WorldTransform, const MeshRender>().each([&](const WorldTransform& worldTransform, const MeshRender& meshRender) {
+            meshRenderer.draw(*meshRender.mesh, *const_cast<Texture2D*>(meshRender.texture), worldTransform.matrix);
         });
 
         meshRenderer.present(camera, cameraPosition);
@@ -0,0 +1,36 @@
+#include <engine/game/systems/spatialsortsystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr int BITS = 21;
+
+// Insert two zero bits in front of each of the lower 21 bits.
+uint64_t spreadBits(uint64_t _x) {
+    _x &= (uint64_t(1) << BITS) - 1;
+    _x = (_x | _x << 32) & 0x1f00000000ffffull;
+    _x = (_x | _x << 16) & 0x1f0000ff0000ffull;
+    _x = (_x | _x << 8) & 0x100f00f00f00f00full;
+    _x = (_x | _x << 4) & 0x10c30c30c30c30c3ull;
+    _x = (_x | _x << 2) & 0x1249249249249249ull;
+    return _x;
+}
+
+// Grid cell of _x, where cell 2^20 starts at the origin.
+uint64_t quantize(float _x, float _cellSize) {
+    const float cell = std::floor(_x / _cellSize) + static_cast<float>(1 << (BITS - 1));
+    return static_cast<uint64_t>(std::clamp(cell, 0.0f, static_cast<float>((1 << BITS) - 1)));
+}
+}  // namespace
+
+uint64_t SpatialSortSystem::mortonCode(const glm::vec3& position, float cellSize) {
+    return spreadBits(quantize(position.x, cellSize)) | spreadBits(quantize(position.y, cellSize)) << 1 |
+           spreadBits(quantize(position.z, cellSize)) << 2;
+}
+
+void SpatialSortSystem::update(Registry& registry) {
+    if (numUpdates++ % interval != 0) return;
+
+    registry.getComponents<Transform>().sortBy([&](const Transform& transform) { return mortonCode(transform.position, cellSize); });
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <engine/game/components.hpp>
+#include <engine/game/registry.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Keeps the Transform pool in Morton order of the positions, so that entities which are close in space
+// are close in memory as well and spatial passes like collision detection walk the pools mostly linearly.
+// The order is refreshed every few updates. Bodies move only little in between, so just the components
+// whose position in the order changed are moved.
+class SpatialSortSystem {
+   public:
+    // @param _interval Number of updates from one sort to the next.
+    // @param _cellSize Edge length of the grid cells whose order is computed, entities within a cell keep their order.
+    explicit SpatialSortSystem(unsigned _interval = 30, float _cellSize = 1.0f) : interval(_interval), cellSize(_cellSize) {}
+
+    // Sort the Transform pool if the interval has passed. The pools which share a group with
+    // Transform are permuted as well, so the system has to run exclusively.
+    void update(Registry& registry);
+
+    // Interleaved bits of the grid cell of _position, 21 bits per axis.
+    static uint64_t mortonCode(const glm::vec3& position, float cellSize);
+
+   private:
+    unsigned interval;
+    float cellSize;
+    unsigned numUpdates = 0;
+};
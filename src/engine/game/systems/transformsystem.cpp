@@ -0,0 +1,102 @@
+#include <engine/game/systems/transformsystem.hpp>
+#include <engine/utils/threadpool.hpp>
+
+#include <array>
+#include <cstddef>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace {
+// The kernel treats a transform as 12 floats: position, velocity, rotation, angularVelocity.
+// Floats 0-2 and 6-8 are incremented by the floats 3 positions behind them.
+constexpr size_t FLOATS = 12;
+static_assert(sizeof(Transform) == FLOATS * sizeof(float), "Transform has to consist of four packed glm::vec3.");
+static_assert(offsetof(Transform, velocity) == offsetof(Transform, position) + 3 * sizeof(float) &&
+                  offsetof(Transform, rotation) == offsetof(Transform, position) + 6 * sizeof(float) &&
+                  offsetof(Transform, angularVelocity) == offsetof(Transform, position) + 9 * sizeof(float),
+              "Unexpected Transform layout.");
+
+constexpr bool isIntegrated(size_t _float) {
+    return _float % FLOATS < 3 || (_float % FLOATS >= 6 && _float % FLOATS < 9);
+}
+
+// Lane masks for a block of Width transforms, which has the same pattern for every block since
+// Width * FLOATS floats are exactly FLOATS vectors.
+template <size_t Width>
+constexpr std::array<uint32_t, Width * FLOATS> makeMasks() {
+    std::array<uint32_t, Width * FLOATS> masks{};
+    for (size_t i = 0; i < masks.size(); ++i) masks[i] = isIntegrated(i) ? ~uint32_t(0) : 0;
+    return masks;
+}
+
+void integrateScalar(float* _data, size_t _count) {
+    for (size_t i = 0; i < _count * FLOATS; ++i) {
+        if (isIntegrated(i)) _data[i] += _data[i + 3];
+    }
+}
+
+#if defined(__AVX__)
+constexpr size_t WIDTH = 8;
+alignas(32) constexpr std::array<uint32_t, WIDTH * FLOATS> MASKS = makeMasks<WIDTH>();
+
+// Blocks of 8 transforms as 12 vectors. The unaligned load reads 3 floats past the block,
+// so the caller has to make sure that another transform follows.
+void integrateBlock(float* _block) {
+    for (size_t i = 0; i < FLOATS; ++i) {
+        float* data = _block + i * WIDTH;
+        const __m256 value = _mm256_loadu_ps(data);
+        const __m256 sum = _mm256_add_ps(value, _mm256_loadu_ps(data + 3));
+        const __m256 mask = _mm256_load_ps(reinterpret_cast<const float*>(&MASKS[i * WIDTH]));
+        _mm256_storeu_ps(data, _mm256_blendv_ps(value, sum, mask));
+    }
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr size_t WIDTH = 4;
+alignas(16) constexpr std::array<uint32_t, WIDTH * FLOATS> MASKS = makeMasks<WIDTH>();
+
+// Blocks of 4 transforms as 12 vectors, see the AVX version.
+void integrateBlock(float* _block) {
+    for (size_t i = 0; i < FLOATS; ++i) {
+        float* data = _block + i * WIDTH;
+        const __m128 value = _mm_loadu_ps(data);
+        const __m128 sum = _mm_add_ps(value, _mm_loadu_ps(data + 3));
+        const __m128 mask = _mm_load_ps(reinterpret_cast<const float*>(&MASKS[i * WIDTH]));
+        _mm_storeu_ps(data, _mm_or_ps(_mm_and_ps(mask, sum), _mm_andnot_ps(mask, value)));
+    }
+}
+#else
+constexpr size_t WIDTH = 1;
+
+void integrateBlock(float* _block) {
+    integrateScalar(_block, 1);
+}
+#endif
+}  // namespace
+
+void TransformSystem::integrate(Transform* transforms, size_t count) {
+    float* data = reinterpret_cast<float*>(transforms);
+    // Lanes which are not integrated are blended back, so they keep their exact value.
+    size_t i = 0;
+    for (; i + WIDTH < count; i += WIDTH) integrateBlock(data + i * FLOATS);
+    integrateScalar(data + i * FLOATS, count - i);
+}
+
+void TransformSystem::updateTransforms(Registry& registry) {
+    auto& transforms = registry.getComponents<Transform>();
+    utils::ThreadPool& threadPool = utils::ThreadPool::global();
+
+    threadPool.parallelFor(transforms.numPages(), 1, [&](size_t begin, size_t end) {
+        for (size_t page = begin; page < end; ++page) {
+            const std::span<Transform> data = transforms.getPage(page);
+            integrate(data.data(), data.size());
+
+            const size_t first = page * ComponentAccess<Transform>::PAGE_SIZE;
+            for (size_t i = 0; i < data.size(); ++i) {
+                if (data[i].velocity != glm::vec3(0.0f) || data[i].angularVelocity != glm::vec3(0.0f))
+                    transforms.markChangedAt(first + i);
+            }
+        }
+    });
+}
@@ -3,16 +3,25 @@
 #include <engine/game/components.hpp>
 #include <engine/game/registry.hpp>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 using namespace graphics;
 
 class TransformSystem {
    public:
-    static void updateTransforms(Registry& registry) {
+    // Integrate the velocities of all transforms, page by page on the worker threads.
+    // Only transforms which actually move are flagged as changed.
+    static void updateTransforms(Registry& registry);
 
-        registry.execute<Entity, Transform>([&](Entity& entity, Transform& transform) {
-            transform.position += transform.velocity;
-            transform.rotation += transform.angularVelocity;
-        });
+    // position += velocity and rotation += angularVelocity for _count consecutive transforms.
+    // Uses AVX or SSE2 if the target supports it.
+    static void integrate(Transform* transforms, size_t count);
+
+    static glm::mat4 getModelMatrix(const Transform& transform, const TransformScale& scale) {
+        glm::mat4 matrix = glm::translate(glm::mat4(1.0f), transform.position);
+        matrix = glm::rotate(matrix, transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+        matrix = glm::rotate(matrix, transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+        matrix = glm::rotate(matrix, transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+        return glm::scale(matrix, scale.scale);
     }
 };
\ No newline at end of file
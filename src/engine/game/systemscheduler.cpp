@@ -0,0 +1,112 @@
+#include <engine/game/systemscheduler.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+void SystemScheduler::addExclusiveSystem(const std::string& _name, SystemFunction _function) {
+    System system{_name, std::move(_function)};
+    system.exclusive = true;
+    systems.push_back(std::move(system));
+    graphDirty = true;
+}
+
+bool SystemScheduler::conflicts(const System& _first, const System& _second) {
+    if (_first.exclusive || _second.exclusive) return true;
+
+    auto intersect = [](const std::vector<uint32_t>& _a, const std::vector<uint32_t>& _b) {
+        return std::any_of(_a.begin(), _a.end(), [&](uint32_t _type) {
+            return std::find(_b.begin(), _b.end(), _type) != _b.end();
+        });
+    };
+
+    return intersect(_first.writes, _second.writes) || intersect(_first.writes, _second.reads) ||
+           intersect(_first.reads, _second.writes);
+}
+
+void SystemScheduler::buildGraph() {
+    for (System& system : systems) {
+        system.dependents.clear();
+        system.numDependencies = 0;
+    }
+
+    for (size_t i = 0; i < systems.size(); ++i) {
+        for (size_t j = i + 1; j < systems.size(); ++j) {
+            if (conflicts(systems[i], systems[j])) {
+                systems[i].dependents.push_back(j);
+                ++systems[j].numDependencies;
+            }
+        }
+    }
+
+    graphDirty = false;
+}
+
+namespace {
+// Shared between the calling thread and the helper jobs of a single SystemScheduler::run().
+struct RunState {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<size_t> ready;
+    std::vector<size_t> remainingDependencies;
+    size_t remainingSystems = 0;
+};
+}  // namespace
+
+void SystemScheduler::run(Registry& _registry, utils::ThreadPool& _threadPool) {
+    if (graphDirty) buildGraph();
+    if (systems.empty()) return;
+
+    for (System& system : systems) {
+        for (auto createPool : system.createPools) createPool(_registry);
+    }
+
+    // Without workers the registration order is a valid schedule.
+    if (_threadPool.numThreads() == 0) {
+        for (System& system : systems) system.function(_registry);
+        return;
+    }
+
+    auto state = std::make_shared<RunState>();
+    state->remainingSystems = systems.size();
+    for (size_t i = 0; i < systems.size(); ++i) {
+        state->remainingDependencies.push_back(systems[i].numDependencies);
+        if (systems[i].numDependencies == 0) state->ready.push_back(i);
+    }
+
+    // Runs a ready system and releases its dependents.
+    // Must be called with a locked mutex, which is unlocked while the system runs.
+    auto execute = [this, &_registry](RunState& _state, std::unique_lock<std::mutex>& _lock) {
+        const size_t index = _state.ready.front();
+        _state.ready.pop_front();
+        _lock.unlock();
+
+        systems[index].function(_registry);
+
+        _lock.lock();
+        for (size_t dependent : systems[index].dependents) {
+            if (--_state.remainingDependencies[dependent] == 0) _state.ready.push_back(dependent);
+        }
+        --_state.remainingSystems;
+        _state.changed.notify_all();
+    };
+
+    // Helpers return as soon as nothing is ready, the calling thread waits for everything.
+    // They only access the systems while the calling thread is still inside run().
+    auto helper = [state, execute]() {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (!state->ready.empty()) execute(*state, lock);
+    };
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (state->remainingSystems > 0) {
+        for (size_t i = 1; i < state->ready.size(); ++i) _threadPool.run(helper);
+
+        if (!state->ready.empty())
+            execute(*state, lock);
+        else
+            state->changed.wait(lock);
+    }
+}
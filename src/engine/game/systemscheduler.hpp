@@ -0,0 +1,70 @@
+#pragma once
+
+#include <engine/game/registry.hpp>
+#include <engine/utils/threadpool.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs a set of systems on a Registry, using multiple threads where possible.
+// Every system declares the components it accesses. Systems with conflicting accesses
+// (one of them writes a component the other one reads or writes) run in the order they were
+// added, all other systems may run concurrently.
+class SystemScheduler {
+   public:
+    using SystemFunction = std::function<void(Registry&)>;
+
+    // Add a system accessing Components... Const-qualified components are only read,
+    // all others may be written, e.g. addSystem<Transform, const MeshCollider>(...).
+    // Tags are declared the same way, writing a tag means inserting or erasing it.
+    // The system must not change the structure of the registry (create, erase, insert).
+    template <typename... Components>
+    void addSystem(const std::string& _name, SystemFunction _function) {
+        System system{_name, std::move(_function)};
+        (addAccess<Components>(system), ...);
+        systems.push_back(std::move(system));
+        graphDirty = true;
+    }
+
+    // Add a system which may change the structure of the registry.
+    // It runs after all previously added systems and before all systems added later on.
+    void addExclusiveSystem(const std::string& _name, SystemFunction _function);
+
+    // Run every system once.
+    void run(Registry& _registry, utils::ThreadPool& _threadPool = utils::ThreadPool::global());
+
+   private:
+    struct System {
+        std::string name;
+        SystemFunction function;
+        std::vector<uint32_t> reads;
+        std::vector<uint32_t> writes;
+        bool exclusive = false;
+        // Pools are created before any system runs, so that concurrent systems only read the pool map.
+        std::vector<void (*)(Registry&)> createPools;
+
+        // Systems which have to wait for this one.
+        std::vector<size_t> dependents;
+        size_t numDependencies = 0;
+    };
+
+    template <typename Component>
+    static void addAccess(System& _system) {
+        using Type = std::remove_const_t<Component>;
+        if constexpr (details::is_tag_v<Type>)
+            _system.createPools.push_back([](Registry& _registry) { _registry.getTags<Type>(); });
+        else
+            _system.createPools.push_back([](Registry& _registry) { _registry.getComponents<Type>(); });
+        if constexpr (std::is_const_v<Component>)
+            _system.reads.push_back(Registry::componentId<Component>());
+        else
+            _system.writes.push_back(Registry::componentId<Component>());
+    }
+
+    static bool conflicts(const System& _first, const System& _second);
+    void buildGraph();
+
+    std::vector<System> systems;
+    bool graphDirty = false;
+};
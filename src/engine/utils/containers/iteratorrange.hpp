@@ -1,6 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <iterator>
 #include <utility>
+#include <vector>
 
 namespace utils {
 
@@ -14,44 +19,87 @@ namespace utils {
 			static const Value& value(const Container& _this, SizeType _index);
 		};
 	* */
+	// Dereferencing yields a std::pair<Key, Value&> by value. Such proxies only satisfy the C++20
+	// std::random_access_iterator concept, for the legacy iterator_traits the iterators are input iterators.
+	// A range created from the whole container reads the size on every end(), so it also covers
+	// elements inserted later on. Ranges from chunks() keep their bounds.
 	template<typename Container, typename Key, typename Value, typename Accessor>
 	class IteratorRange
 	{
 		using SizeType = typename Container::SizeType;
 	public:
-		IteratorRange(Container& _target) : m_target(_target) {}
+		IteratorRange(Container& _target) : m_target(_target), m_begin(0), m_end(WHOLE) {}
+		IteratorRange(Container& _target, SizeType _begin, SizeType _end) : m_target(_target), m_begin(_begin), m_end(_end) {}
 
 		class Iterator
 		{
 		public:
-			Iterator(Container& _target, SizeType _ind) : m_target(_target), m_index(_ind) {}
+			using iterator_concept = std::random_access_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = std::pair<Key, Value&>;
+			using reference = std::pair<Key, Value&>;
+			using pointer = void;
 
-			Key key() const { return Accessor::key(m_target, m_index); }
-			Value& value() const { return Accessor::value(m_target, m_index); }
+			Iterator() = default;
+			Iterator(Container& _target, SizeType _ind) : m_target(&_target), m_index(_ind) {}
 
-			std::pair<Key, Value&> operator*()
-			{
-				return std::pair<Key, Value&>(Accessor::key(m_target, m_index), Accessor::value(m_target, m_index));
-			}
-			std::pair<Key, const Value&> operator*() const
+			Key key() const { return Accessor::key(*m_target, m_index); }
+			Value& value() const { return Accessor::value(*m_target, m_index); }
+
+			reference operator*() const
 			{
-				return std::pair<Key, const Value&>(Accessor::key(m_target, m_index), Accessor::value(m_target, m_index));
+				return reference(Accessor::key(*m_target, m_index), Accessor::value(*m_target, m_index));
 			}
+			reference operator[](difference_type _n) const { return *(*this + _n); }
 
 			Iterator& operator++() { ++m_index; return *this; }
 			Iterator operator++(int) { Iterator tmp(*this);  ++m_index; return tmp; }
-			bool operator==(const Iterator& _oth) const { ASSERT(&m_target == &_oth.m_target, "Comparing iterators of different containers."); return m_index == _oth.m_index; }
-			bool operator!=(const Iterator& _oth) const { ASSERT(&m_target == &_oth.m_target, "Comparing iterators of different containers."); return m_index != _oth.m_index; }
+			Iterator& operator--() { --m_index; return *this; }
+			Iterator operator--(int) { Iterator tmp(*this);  --m_index; return tmp; }
+			Iterator& operator+=(difference_type _n) { m_index = static_cast<SizeType>(m_index + _n); return *this; }
+			Iterator& operator-=(difference_type _n) { m_index = static_cast<SizeType>(m_index - _n); return *this; }
+			friend Iterator operator+(Iterator _it, difference_type _n) { return _it += _n; }
+			friend Iterator operator+(difference_type _n, Iterator _it) { return _it += _n; }
+			friend Iterator operator-(Iterator _it, difference_type _n) { return _it -= _n; }
+			friend difference_type operator-(const Iterator& _a, const Iterator& _b)
+			{
+				ASSERT(_a.m_target == _b.m_target, "Subtracting iterators of different containers.");
+				return static_cast<difference_type>(_a.m_index) - static_cast<difference_type>(_b.m_index);
+			}
+
+			bool operator==(const Iterator& _oth) const { ASSERT(m_target == _oth.m_target, "Comparing iterators of different containers."); return m_index == _oth.m_index; }
+			std::strong_ordering operator<=>(const Iterator& _oth) const { ASSERT(m_target == _oth.m_target, "Comparing iterators of different containers."); return m_index <=> _oth.m_index; }
 		private:
-			Container& m_target;
-			SizeType m_index;
+			Container* m_target = nullptr;
+			SizeType m_index = 0;
 		};
 
-		Iterator begin() const { return Iterator(m_target, 0); }
-		Iterator end() const { return Iterator(m_target, m_target.size()); }
+		Iterator begin() const { return Iterator(m_target, m_begin); }
+		Iterator end() const { return Iterator(m_target, endIndex()); }
+		SizeType size() const { return endIndex() - m_begin; }
+
+		// Split into consecutive ranges of at most _chunkSize elements, e.g. one per job.
+		std::vector<IteratorRange> chunks(SizeType _chunkSize) const
+		{
+			_chunkSize = std::max<SizeType>(_chunkSize, 1);
+			std::vector<IteratorRange> result;
+			result.reserve((size() + _chunkSize - 1) / _chunkSize);
+			const SizeType end = endIndex();
+			for (SizeType begin = m_begin; begin < end; begin += std::min<SizeType>(_chunkSize, end - begin))
+				result.emplace_back(m_target, begin, begin + std::min<SizeType>(_chunkSize, end - begin));
+			return result;
+		}
 
 	private:
+		// m_end of a range over the whole container.
+		static constexpr SizeType WHOLE = ~SizeType(0);
+
+		SizeType endIndex() const { return m_end == WHOLE ? static_cast<SizeType>(m_target.size()) : m_end; }
+
 		Container& m_target;
+		SizeType m_begin;
+		SizeType m_end;
 	};
 
 	template<typename Container, typename Key, typename Value, typename Accessor>
@@ -59,34 +107,76 @@ namespace utils {
 	{
 		using SizeType = typename Container::SizeType;
 	public:
-		ConstIteratorRange(const Container& _target) : m_target(_target) {}
+		ConstIteratorRange(const Container& _target) : m_target(_target), m_begin(0), m_end(WHOLE) {}
+		ConstIteratorRange(const Container& _target, SizeType _begin, SizeType _end) : m_target(_target), m_begin(_begin), m_end(_end) {}
 
 		class Iterator
 		{
 		public:
-			Iterator(const Container& _target, SizeType _ind) : m_target(_target), m_index(_ind) {}
+			using iterator_concept = std::random_access_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = std::pair<Key, const Value&>;
+			using reference = std::pair<Key, const Value&>;
+			using pointer = void;
 
-			Key key() const { return Accessor::key(m_target, m_index); }
-			const Value& value() const { return Accessor::value(m_target, m_index); }
+			Iterator() = default;
+			Iterator(const Container& _target, SizeType _ind) : m_target(&_target), m_index(_ind) {}
 
-			std::pair<Key, const Value&> operator*() const 
-			{ 
-				return std::pair<Key, const Value&>(Accessor::key(m_target, m_index), Accessor::value(m_target, m_index));
+			Key key() const { return Accessor::key(*m_target, m_index); }
+			const Value& value() const { return Accessor::value(*m_target, m_index); }
+
+			reference operator*() const
+			{
+				return reference(Accessor::key(*m_target, m_index), Accessor::value(*m_target, m_index));
 			}
+			reference operator[](difference_type _n) const { return *(*this + _n); }
 
 			Iterator& operator++() { ++m_index; return *this; }
 			Iterator operator++(int) { Iterator tmp(*this);  ++m_index; return tmp; }
-			bool operator==(const Iterator& _oth) const { ASSERT(&m_target == &_oth.m_target, "Comparing iterators of different containers."); return m_index == _oth.m_index; }
-			bool operator!=(const Iterator& _oth) const { ASSERT(&m_target == &_oth.m_target, "Comparing iterators of different containers."); return m_index != _oth.m_index; }
+			Iterator& operator--() { --m_index; return *this; }
+			Iterator operator--(int) { Iterator tmp(*this);  --m_index; return tmp; }
+			Iterator& operator+=(difference_type _n) { m_index = static_cast<SizeType>(m_index + _n); return *this; }
+			Iterator& operator-=(difference_type _n) { m_index = static_cast<SizeType>(m_index - _n); return *this; }
+			friend Iterator operator+(Iterator _it, difference_type _n) { return _it += _n; }
+			friend Iterator operator+(difference_type _n, Iterator _it) { return _it += _n; }
+			friend Iterator operator-(Iterator _it, difference_type _n) { return _it -= _n; }
+			friend difference_type operator-(const Iterator& _a, const Iterator& _b)
+			{
+				ASSERT(_a.m_target == _b.m_target, "Subtracting iterators of different containers.");
+				return static_cast<difference_type>(_a.m_index) - static_cast<difference_type>(_b.m_index);
+			}
+
+			bool operator==(const Iterator& _oth) const { ASSERT(m_target == _oth.m_target, "Comparing iterators of different containers."); return m_index == _oth.m_index; }
+			std::strong_ordering operator<=>(const Iterator& _oth) const { ASSERT(m_target == _oth.m_target, "Comparing iterators of different containers."); return m_index <=> _oth.m_index; }
 		private:
-			const Container& m_target;
-			SizeType m_index;
+			const Container* m_target = nullptr;
+			SizeType m_index = 0;
 		};
 
-		Iterator begin() const { return Iterator(m_target, 0); }
-		Iterator end() const { return Iterator(m_target, m_target.size()); }
+		Iterator begin() const { return Iterator(m_target, m_begin); }
+		Iterator end() const { return Iterator(m_target, endIndex()); }
+		SizeType size() const { return endIndex() - m_begin; }
+
+		// Split into consecutive ranges of at most _chunkSize elements, see IteratorRange::chunks.
+		std::vector<ConstIteratorRange> chunks(SizeType _chunkSize) const
+		{
+			_chunkSize = std::max<SizeType>(_chunkSize, 1);
+			std::vector<ConstIteratorRange> result;
+			result.reserve((size() + _chunkSize - 1) / _chunkSize);
+			const SizeType end = endIndex();
+			for (SizeType begin = m_begin; begin < end; begin += std::min<SizeType>(_chunkSize, end - begin))
+				result.emplace_back(m_target, begin, begin + std::min<SizeType>(_chunkSize, end - begin));
+			return result;
+		}
 
 	private:
+		static constexpr SizeType WHOLE = ~SizeType(0);
+
+		SizeType endIndex() const { return m_end == WHOLE ? static_cast<SizeType>(m_target.size()) : m_end; }
+
 		const Container& m_target;
+		SizeType m_begin;
+		SizeType m_end;
 	};
 }
\ No newline at end of file
@@ -5,6 +5,11 @@
 #include <limits>
 #include <utility>
 #include <concepts>
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
 
 namespace utils {
 	template<std::integral Key, std::movable Value>
@@ -53,28 +58,61 @@ namespace utils {
 		}
 
 		// iterators
+		// Random access, so the values can be split with chunks() or passed to parallel algorithms.
 		class Iterator
 		{
 		public:
-			Iterator(SlotMap& _target, std::size_t _ind) : m_target(_target), m_index(_ind) {}
+			using iterator_category = std::random_access_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = Value;
+			using reference = Value&;
+			using pointer = Value*;
 
-			Key key() const { return m_target.m_valuesToSlots[m_index]; }
-			Value& value() { return m_target.m_values[m_index]; }
+			Iterator() = default;
+			Iterator(SlotMap& _target, std::size_t _ind) : m_index(_ind), m_target(&_target) {}
 
-			Value& operator*() { return m_target.m_values[m_index]; }
-			const Value& operator*() const { return m_target.m_values[m_index]; }
+			Key key() const { return m_target->m_valuesToSlots[m_index]; }
+			Value& value() const { return m_target->m_values[m_index]; }
+
+			Value& operator*() const { return m_target->m_values[m_index]; }
+			Value* operator->() const { return &m_target->m_values[m_index]; }
+			Value& operator[](difference_type _n) const { return m_target->m_values[m_index + _n]; }
 
 			Iterator& operator++() { ++m_index; return *this; }
 			Iterator operator++(int) { Iterator tmp(*this);  ++m_index; return tmp; }
-			bool operator==(const Iterator& _oth) const { ASSERT(&m_target == &_oth.m_target, "Comparing iterators of different containers."); return m_index == _oth.m_index; }
-			bool operator!=(const Iterator& _oth) const { ASSERT(&m_target == &_oth.m_target, "Comparing iterators of different containers."); return m_index != _oth.m_index; }
+			Iterator& operator--() { --m_index; return *this; }
+			Iterator operator--(int) { Iterator tmp(*this);  --m_index; return tmp; }
+			Iterator& operator+=(difference_type _n) { m_index += _n; return *this; }
+			Iterator& operator-=(difference_type _n) { m_index -= _n; return *this; }
+			friend Iterator operator+(Iterator _it, difference_type _n) { return _it += _n; }
+			friend Iterator operator+(difference_type _n, Iterator _it) { return _it += _n; }
+			friend Iterator operator-(Iterator _it, difference_type _n) { return _it -= _n; }
+			friend difference_type operator-(const Iterator& _a, const Iterator& _b)
+			{
+				ASSERT(_a.m_target == _b.m_target, "Subtracting iterators of different containers.");
+				return static_cast<difference_type>(_a.m_index) - static_cast<difference_type>(_b.m_index);
+			}
+
+			bool operator==(const Iterator& _oth) const { ASSERT(m_target == _oth.m_target, "Comparing iterators of different containers."); return m_index == _oth.m_index; }
+			std::strong_ordering operator<=>(const Iterator& _oth) const { ASSERT(m_target == _oth.m_target, "Comparing iterators of different containers."); return m_index <=> _oth.m_index; }
 		private:
-			std::size_t m_index;
-			SlotMap& m_target;
+			std::size_t m_index = 0;
+			SlotMap* m_target = nullptr;
 		};
 		auto begin() { return Iterator(*this, 0); }
 		auto end() { return Iterator(*this, m_values.size()); }
 
+		// Split the values into consecutive ranges of at most _chunkSize elements, e.g. one per job.
+		std::vector<std::ranges::subrange<Iterator>> chunks(std::size_t _chunkSize)
+		{
+			_chunkSize = std::max<std::size_t>(_chunkSize, 1);
+			std::vector<std::ranges::subrange<Iterator>> result;
+			result.reserve((size() + _chunkSize - 1) / _chunkSize);
+			for (std::size_t begin = 0; begin < size(); begin += _chunkSize)
+				result.emplace_back(Iterator(*this, begin), Iterator(*this, std::min(begin + _chunkSize, size())));
+			return result;
+		}
+
 		// access operations
 		bool contains(Key _key) const { return _key < m_slots.size() && m_slots[_key] != INVALID_SLOT; }
 		
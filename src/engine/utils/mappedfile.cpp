@@ -0,0 +1,61 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& _fileName)
+	{
+		m_file = CreateFileA(_fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE) { m_file = nullptr; return; }
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return;
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_mapping) return;
+
+		m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_data) m_size = static_cast<size_t>(size.QuadPart);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_data) UnmapViewOfFile(m_data);
+		if (m_mapping) CloseHandle(m_mapping);
+		if (m_file) CloseHandle(m_file);
+	}
+#else
+	MappedFile::MappedFile(const std::string& _fileName)
+	{
+		const int file = open(_fileName.c_str(), O_RDONLY);
+		if (file < 0) return;
+
+		struct stat status;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED)
+			{
+				m_data = static_cast<const char*>(data);
+				m_size = static_cast<size_t>(status.st_size);
+			}
+		}
+		// The mapping stays valid after closing the descriptor.
+		close(file);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_data) munmap(const_cast<char*>(m_data), m_size);
+	}
+#endif
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace utils {
+
+	/// @brief Read-only memory mapping of a whole file.
+	class MappedFile
+	{
+	public:
+		/// @details Check isOpen() to find out whether the file could be mapped.
+		explicit MappedFile(const std::string& _fileName);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool isOpen() const { return m_data != nullptr; }
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+	private:
+		const char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+}
@@ -34,4 +34,14 @@ namespace utils {
 
 	template<typename What, typename ... Args>
 	constexpr bool contains_type_v = contains_type<What, Args...>::value;
+
+	// Determine whether T is an instance of the class template Template.
+	template<typename T, template<typename...> class Template>
+	struct is_specialization : std::false_type {};
+
+	template<template<typename...> class Template, typename... Args>
+	struct is_specialization<Template<Args...>, Template> : std::true_type {};
+
+	template<typename T, template<typename...> class Template>
+	constexpr bool is_specialization_v = is_specialization<T, Template>::value;
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "threadpool.hpp"
+
+namespace utils {
+
+	ThreadPool::ThreadPool(unsigned _numThreads)
+	{
+		m_threads.reserve(_numThreads);
+		for (unsigned i = 0; i < _numThreads; ++i)
+			m_threads.emplace_back(&ThreadPool::workerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_condition.notify_all();
+
+		for (std::thread& thread : m_threads)
+			thread.join();
+	}
+
+	ThreadPool& ThreadPool::global()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::run(std::function<void()> _job)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobs.push_back(std::move(_job));
+		}
+		m_condition.notify_one();
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+				if (m_stop && m_jobs.empty()) return;
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	void ThreadPool::ParallelForState::work()
+	{
+		while (true)
+		{
+			size_t chunk;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (nextChunk == numChunks) return;
+				chunk = nextChunk++;
+			}
+
+			const size_t begin = chunk * chunkSize;
+			invoke(func, begin, std::min(begin + chunkSize, count));
+
+			std::unique_lock<std::mutex> lock(mutex);
+			if (++completedChunks == numChunks)
+				finished.notify_all();
+		}
+	}
+
+	void ThreadPool::ParallelForState::wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this]() { return completedChunks == numChunks; });
+	}
+}
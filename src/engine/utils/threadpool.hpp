@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+	/// @brief Fixed set of worker threads which execute jobs from a shared queue.
+	class ThreadPool
+	{
+	public:
+		/// @param _numThreads Number of worker threads. The thread calling
+		///		parallelFor() participates as well.
+		explicit ThreadPool(unsigned _numThreads = std::max(1u, std::thread::hardware_concurrency()) - 1);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/// @brief Pool shared by the engine systems.
+		static ThreadPool& global();
+
+		/// @brief Enqueue a job to be run on one of the workers.
+		void run(std::function<void()> _job);
+
+		/// @brief Execute _func(begin, end) for consecutive ranges of at most _chunkSize 
+		///		elements covering [0, _count).
+		/// @details The calling thread processes chunks as well and only returns once all
+		///		chunks are done. Can be called from within a job without risking a deadlock.
+		template<typename Func>
+		void parallelFor(size_t _count, size_t _chunkSize, const Func& _func)
+		{
+			if (_count == 0) return;
+			_chunkSize = std::max<size_t>(_chunkSize, 1);
+			const size_t numChunks = (_count + _chunkSize - 1) / _chunkSize;
+			if (numChunks == 1 || m_threads.empty())
+			{
+				_func(size_t(0), _count);
+				return;
+			}
+
+			auto state = std::make_shared<ParallelForState>();
+			state->count = _count;
+			state->chunkSize = _chunkSize;
+			state->numChunks = numChunks;
+			state->func = &_func;
+			state->invoke = [](const void* _f, size_t _begin, size_t _end)
+			{
+				(*static_cast<const Func*>(_f))(_begin, _end);
+			};
+
+			const size_t numHelpers = std::min(numChunks - 1, m_threads.size());
+			for (size_t i = 0; i < numHelpers; ++i)
+				run([state]() { state->work(); });
+
+			state->work();
+			state->wait();
+		}
+
+		/// @brief Suggested chunk size to split _count elements evenly among all threads.
+		size_t chunkSize(size_t _count, size_t _minChunkSize = 64) const
+		{
+			const size_t numChunks = (m_threads.size() + 1) * 4;
+			return std::max(_minChunkSize, (_count + numChunks - 1) / numChunks);
+		}
+
+		size_t numThreads() const { return m_threads.size(); }
+
+	private:
+		struct ParallelForState
+		{
+			// Process chunks until none is left.
+			void work();
+			void wait();
+
+			size_t count;
+			size_t chunkSize;
+			size_t numChunks;
+			const void* func;
+			void (*invoke)(const void*, size_t, size_t);
+
+			std::mutex mutex;
+			std::condition_variable finished;
+			size_t nextChunk = 0;
+			size_t completedChunks = 0;
+		};
+
+		void workerLoop();
+
+		std::vector<std::thread> m_threads;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stop = false;
+	};
+}
@@ -0,0 +1,6 @@
+#include "typeindex.hpp"
+
+namespace utils {
+
+	std::atomic<int> TypeIndex::s_counter = 0;
+}
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <atomic>
+
 namespace utils {
 	// Simple type index with some runtime overhead.
+	// Ids are dense and assigned on first use, so they can be used to index arrays.
 	// Use static_type_info::getTypeIndex() instead if only hashes are needed!
 	class TypeIndex
 	{
-		static int s_counter;
+		static std::atomic<int> s_counter;
 	public:
 		template<typename T>
 		static int value()
@@ -15,4 +18,4 @@ namespace utils {
 		}
 	};
 
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include <engine/game/states/statemanager.hpp>
+#include <engine/utils/config.hpp>
 #include <game/states/dynamicstate.hpp>
 #include <game/states/physicsstate.hpp>
 #include <game/states/springstate.hpp>
@@ -18,41 +19,61 @@ static const std::vector<Light> lights = {{glm::vec3(1.2f, -3.f, 2.f), glm::vec3
                                           {glm::vec3(2.f, -2.f, 1.f), glm::vec3(0.f, 0.f, 1.f)},
                                           {glm::vec3(1.f, -3.f, 1.f), glm::vec3(0.f, 0.f, 1.f)}};
 
+const float maxDistance = 10.0f;
+const float spawningInterval = 0.5f;
+float interval = 0;
+
 DynamicState::DynamicState() : camera(90.0f, 0.1f, 100.0f),
                                cameraPosition(cameraStartPosition),
                                mesh(*utils::MeshLoader::get("/models/sphere.obj")),
-                               texture(Texture2DManager::get("/textures/moon.jpg", *StateManager::sampler)) {
+                               texture(Texture2DManager::get("/textures/moon.jpg", *StateManager::sampler)),
+                               spherePrefab(Transform{}, AABBCollider{math::Box(math::HyperSphere<3, float>(glm::vec3(0.0f), 1.0f))},
+                                            MeshRender{&mesh, texture}) {
     camera.setView(glm::lookAt(cameraStartPosition, cameratStartLookAt, cameraUp));
 
+    // Per frame memory and churn of the pools, enabled by "logRegistryStats": true in config.json.
+    const nlohmann::json& config = utils::Config::get();
+    logRegistryStats = config.is_object() && config.value("logRegistryStats", false);
+
     LightSystem::addLights(registry, lights);
     LightSystem::updateLights(registry, meshRenderer.getProgram());
+
+    scheduler.addExclusiveSystem("spatialSort", [this](Registry& _registry) { spatialSort.update(_registry); });
+    scheduler.addSystem<Transform>("transforms", TransformSystem::updateTransforms);
+    scheduler.addSystem<const Transform>("despawn", [this](Registry& _registry) {
+        _registry.executeParallel<Entity, const Transform>([&](Entity& entity, const Transform& transform) {
+            if (glm::distance(transform.position, cameraStartPosition) >= maxDistance) {
+                commands.erase(entity);
+            }
+        });
+    });
+    scheduler.addExclusiveSystem("aabbCollisions", CollisionSystem::updateAABBCollisions);
+    scheduler.addExclusiveSystem("worldMatrices", [this](Registry& _registry) { hierarchy.updateWorldMatrices(_registry); });
 }
 
 void DynamicState::draw(float time, float deltaTime) {
-    RenderSystem::draw(registry, meshRenderer, camera, cameraPosition);
+    const RenderSnapshot::Frame& frame = snapshot.acquire();
+    LightSystem::gatherLights(frame.get<Light>(), lights);
+    LightSystem::uploadLights(lights, meshRenderer.getProgram());
+    RenderSystem::draw(frame, meshRenderer, camera, cameraPosition);
 }
 
-const float maxDistance = 10.0f;
-const float spawningInterval = 0.5f;
-float interval = 0;
-
 void DynamicState::update(float time, float deltaTime) {
-    TransformSystem::updateTransforms(registry);
-
-    registry.execute<Entity, Transform>([&](Entity& entity, Transform& transform) {
-        if (glm::distance(transform.position, cameraStartPosition) >= maxDistance) {
-            registry.erase(entity);
-        }
-    });
+    scheduler.run(registry);
+    // Entities spawned below keep their change flags until the next update.
+    registry.clearChanged();
+    commands.flush(registry);
 
     if (interval <= 0) {
         interval = spawningInterval;
-        createSphere();
+        createSpheres(1);
     }
 
     interval -= deltaTime;
+    snapshot.publish(registry);
 
-    CollisionSystem::updateAABBCollisions(registry);
+    if (logRegistryStats) registry.logStats();
+    registry.resetChurn();
 }
 
 void DynamicState::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
@@ -73,19 +94,16 @@ void DynamicState::mouseButtonCallback(GLFWwindow* window, int button, int actio
         shootProjectile(window);
 }
 
-void DynamicState::createSphere() {
-    Entity newEntity = registry.create();
+void DynamicState::createSpheres(size_t _count) {
+    registry.instantiate(spherePrefab, _count, [&](Entity, Transform& transform, AABBCollider& collider, MeshRender&) {
+        glm::vec3 initialPos = {rFloat(-3.0f, 3.0f), rFloat(-2.0f, 2.0f), rFloat(-1.0f, 1.0f)};
 
-    glm::vec3 initialPos = {rFloat(-3.0f, 3.0f), rFloat(-2.0f, 2.0f), rFloat(-1.0f, 1.0f)};
-
-    registry.getComponents<Transform>().insert(newEntity, {initialPos,
-                                                           {rFloat(-0.01f, 0.01f), rFloat(-0.01f, 0.01f), rFloat(-0.01f, 0.01f)},
-                                                           {rFloat(-1.00f, 1.0f), rFloat(-1.0f, 1.0f), rFloat(-1.0f, 1.0f)},
-                                                           {rFloat(-0.02f, 0.02f), rFloat(-0.02f, 0.02f), rFloat(-0.02f, 0.02f)}});
-
-    registry.getComponents<AABBCollider>().insert(newEntity,
-                                                  {ColliderType::Target, math::Box(math::HyperSphere<3, float>(initialPos, 1.0f))});
-    registry.getComponents<MeshRender>().insert(newEntity, {&mesh, texture});
+        transform = {initialPos,
+                     {rFloat(-0.01f, 0.01f), rFloat(-0.01f, 0.01f), rFloat(-0.01f, 0.01f)},
+                     {rFloat(-1.00f, 1.0f), rFloat(-1.0f, 1.0f), rFloat(-1.0f, 1.0f)},
+                     {rFloat(-0.02f, 0.02f), rFloat(-0.02f, 0.02f), rFloat(-0.02f, 0.02f)}};
+        collider.aabb = math::Box(math::HyperSphere<3, float>(initialPos, 1.0f));
+    });
 }
 
 void DynamicState::shootProjectile(GLFWwindow* window) {
@@ -102,10 +120,10 @@ void DynamicState::shootProjectile(GLFWwindow* window) {
 
     glm::vec3 initialPos = cameraStartPosition - 2.0f * direction;
     Transform transform = {initialPos, {-0.5f * direction}};
-    transform.scale *= scale;
 
-    registry.getComponents<Transform>().insert(newEntity, transform);
-    registry.getComponents<AABBCollider>().insert(newEntity, {ColliderType::Projectile, math::Box(math::HyperSphere<3, float>(initialPos, scale))});
+    registry.getComponents<Transform>().insert(newEntity, transform, {glm::vec3(scale)});
+    registry.getComponents<AABBCollider>().insert(newEntity, {math::Box(math::HyperSphere<3, float>(initialPos, scale))});
+    registry.getTags<Projectile>().insert(newEntity);
     registry.getComponents<MeshRender>().insert(newEntity, {&mesh, texture});
 }
 
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <engine/game/systems/collisionsystem.hpp>
+#include <engine/game/systems/hierarchysystem.hpp>
+#include <engine/game/systems/spatialsortsystem.hpp>
+#include <engine/game/commandbuffer.hpp>
 #include <engine/game/components.hpp>
 #include <engine/game/registry.hpp>
 #include <engine/game/states/gamestate.hpp>
+#include <engine/game/systemscheduler.hpp>
 #include <engine/graphics/camera.hpp>
 #include <engine/graphics/core/device.hpp>
 #include <engine/game/systems/lightsystem.hpp>
+#include <engine/game/systems/rendersystem.hpp>
 #include <engine/graphics/core/sampler.hpp>
 #include <engine/graphics/core/texture.hpp>
 #include <engine/graphics/renderer/mesh.hpp>
@@ -23,8 +28,10 @@ class DynamicState : public GameState {
     void onPause(){};
     void onResume(){};
     bool isFinished() { return finished; };
+    bool drawsConcurrently() { return true; };
     DynamicState();
-    void createSphere();
+    // Spawn _count spheres with random positions and velocities.
+    void createSpheres(size_t _count);
     void shootProjectile(GLFWwindow* window);
     void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
     void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
@@ -36,8 +43,17 @@ class DynamicState : public GameState {
 
     Mesh mesh;
     Texture2D::Handle texture;
+    Prefab<Transform, AABBCollider, MeshRender> spherePrefab;
     Registry registry;
+    SystemScheduler scheduler;
+    HierarchySystem hierarchy;
+    SpatialSortSystem spatialSort;
+    CommandBuffer commands;
+    RenderSnapshot snapshot;
+    // Only accessed by draw().
+    LightSystem::LightData lights;
     utils::SparseOctree<Entity, 3, float> octree;
+    bool logRegistryStats = false;
 
     bool finished = false;
 
@@ -40,16 +40,23 @@ PhysicsState::PhysicsState() : camera(90.0f, 0.1f, 100.0f),
     float mass2 = 10.0f;
     registry.getComponents<PhysicsObject>().insert(crate2, {mass2, CollisionSystem::getCuboidInertiaTensor(2, 4, 2, mass2)});
     CollisionSystem::addMeshCollider(registry, crate2, mesh.meshData);
+
+    scheduler.addSystem<Transform>("transforms", TransformSystem::updateTransforms);
+    scheduler.addSystem<Transform, const MeshCollider, const PhysicsObject>("meshCollisions", [this](Registry& _registry) { collisions.updateMeshCollsions(_registry); });
+    scheduler.addExclusiveSystem("worldMatrices", [this](Registry& _registry) { hierarchy.updateWorldMatrices(_registry); });
 }
 
 void PhysicsState::draw(float time, float deltaTime) {
-    RenderSystem::draw(registry, meshRenderer, camera, cameraPosition);
+    const RenderSnapshot::Frame& frame = snapshot.acquire();
+    LightSystem::gatherLights(frame.get<Light>(), lights);
+    LightSystem::uploadLights(lights, meshRenderer.getProgram());
+    RenderSystem::draw(frame, meshRenderer, camera, cameraPosition);
 }
 
 void PhysicsState::update(float time, float deltaTime) {
-   
-    TransformSystem::updateTransforms(registry);
-    CollisionSystem::updateMeshCollsions(registry);
+    scheduler.run(registry);
+    registry.clearChanged();
+    snapshot.publish(registry);
 }
 
 void PhysicsState::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
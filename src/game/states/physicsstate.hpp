@@ -5,6 +5,8 @@
 #include <engine/game/registry.hpp>
 #include <engine/game/systems/rendersystem.hpp>
 #include <engine/game/states/gamestate.hpp>
+#include <engine/game/systemscheduler.hpp>
+#include <engine/game/systems/hierarchysystem.hpp>
 #include <engine/game/systems/transformsystem.hpp>
 #include <engine/graphics/camera.hpp>
 #include <engine/graphics/core/device.hpp>
@@ -25,6 +27,7 @@ class PhysicsState : public GameState {
     void onPause(){};
     void onResume(){};
     bool isFinished() { return finished; };
+    bool drawsConcurrently() { return true; };
     PhysicsState();
     void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
     void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods){};
@@ -37,6 +40,12 @@ class PhysicsState : public GameState {
     Mesh mesh;
     Texture2D::Handle texture;
     Registry registry;
+    SystemScheduler scheduler;
+    HierarchySystem hierarchy;
+    CollisionSystem collisions{registry};
+    RenderSnapshot snapshot;
+    // Only accessed by draw().
+    LightSystem::LightData lights;
 
     bool finished = false;
 };
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include <engine/game/registry.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// Throughput of the Registry operations at different entity counts.
+// Usage: bench_registry [output.json], the results are written to stdout otherwise.
+
+struct A { float value; };
+struct B { float value; };
+struct C { float value; };
+struct D { float value; };
+
+using json = nlohmann::json;
+using benchClock = std::chrono::steady_clock;
+
+static constexpr int REPETITIONS = 5;
+
+// Accumulates results so that the measured work cannot be optimized away.
+static double checksum = 0.0;
+
+// Best time of several runs of _run in nanoseconds per operation.
+template<typename Run>
+double measure(size_t _numOperations, const Run& _run)
+{
+	double best = std::numeric_limits<double>::max();
+	for (int i = 0; i < REPETITIONS; ++i)
+	{
+		const auto begin = benchClock::now();
+		_run();
+		const std::chrono::duration<double, std::nano> duration = benchClock::now() - begin;
+		best = std::min(best, duration.count() / _numOperations);
+	}
+	return best;
+}
+
+static void report(json& _results, const std::string& _name, size_t _numEntities, double _nsPerOp, double _overlap = 1.0)
+{
+	_results.push_back({
+		{"name", _name},
+		{"entities", _numEntities},
+		{"overlap", _overlap},
+		{"nsPerOp", _nsPerOp},
+		{"opsPerSecond", 1e9 / _nsPerOp}
+	});
+}
+
+static void benchCreateErase(json& _results, size_t _count)
+{
+	Registry registry;
+	std::vector<Entity> entities(_count);
+	const double ns = measure(2 * _count, [&]
+	{
+		for (Entity& ent : entities) ent = registry.create();
+		for (Entity ent : entities) registry.erase(ent);
+	});
+	report(_results, "create_erase", _count, ns);
+}
+
+static void benchInsertErase(json& _results, size_t _count)
+{
+	Registry registry;
+	std::vector<Entity> entities(_count);
+	for (Entity& ent : entities) ent = registry.create();
+
+	auto& pool = registry.getComponents<A>();
+	const double ns = measure(2 * _count, [&]
+	{
+		for (Entity ent : entities) pool.insert(ent, A{1.f});
+		for (Entity ent : entities) pool.erase(ent);
+	});
+	report(_results, "insert_erase", _count, ns);
+}
+
+// Every entity has A, while B, C and D are added independently to a fraction _overlap of the entities.
+static void benchExecute(json& _results, size_t _count, double _overlap)
+{
+	Registry registry;
+	std::mt19937 random(42);
+	std::uniform_real_distribution<double> distribution(0.0, 1.0);
+	for (size_t i = 0; i < _count; ++i)
+	{
+		const Entity ent = registry.create();
+		registry.getComponents<A>().insert(ent, A{1.f});
+		if (distribution(random) < _overlap) registry.getComponents<B>().insert(ent, B{1.f});
+		if (distribution(random) < _overlap) registry.getComponents<C>().insert(ent, C{1.f});
+		if (distribution(random) < _overlap) registry.getComponents<D>().insert(ent, D{1.f});
+	}
+
+	float sum = 0.f;
+	report(_results, "execute_1", _count, measure(_count, [&]
+	{
+		registry.execute<A>([&](A& a) { sum += a.value; });
+	}), _overlap);
+	report(_results, "execute_2", _count, measure(_count, [&]
+	{
+		registry.execute<A, B>([&](A& a, B& b) { sum += a.value + b.value; });
+	}), _overlap);
+	report(_results, "execute_3", _count, measure(_count, [&]
+	{
+		registry.execute<A, B, C>([&](A& a, B& b, C& c) { sum += a.value + b.value + c.value; });
+	}), _overlap);
+	report(_results, "execute_4", _count, measure(_count, [&]
+	{
+		registry.execute<A, B, C, D>([&](A& a, B& b, C& c, D& d) { sum += a.value + b.value + c.value + d.value; });
+	}), _overlap);
+	checksum += sum;
+}
+
+static void benchGetEntity(json& _results, size_t _count)
+{
+	Registry registry;
+	std::vector<EntityRef> refs;
+	for (size_t i = 0; i < _count; ++i) refs.push_back(registry.getRef(registry.create()));
+	// Every second reference is stale.
+	for (size_t i = 0; i < _count; i += 2)
+	{
+		registry.erase(refs[i]);
+		registry.create();
+	}
+	std::shuffle(refs.begin(), refs.end(), std::mt19937(42));
+
+	size_t valid = 0;
+	report(_results, "get_entity", _count, measure(_count, [&]
+	{
+		for (const EntityRef& ref : refs) valid += registry.getEntity(ref).has_value();
+	}));
+	checksum += valid;
+}
+
+static void benchRandomAt(json& _results, size_t _count)
+{
+	Registry registry;
+	std::vector<Entity> entities(_count);
+	for (Entity& ent : entities)
+	{
+		ent = registry.create();
+		registry.getComponents<A>().insert(ent, A{1.f});
+	}
+	std::shuffle(entities.begin(), entities.end(), std::mt19937(42));
+
+	const auto& pool = registry.getComponents<A>();
+	float sum = 0.f;
+	report(_results, "random_at", _count, measure(_count, [&]
+	{
+		for (Entity ent : entities) sum += pool.at(ent)->value;
+	}));
+	checksum += sum;
+}
+
+int main(int argc, char* argv[])
+{
+	json results = json::array();
+	for (size_t count : {10000, 100000, 1000000})
+	{
+		benchCreateErase(results, count);
+		benchInsertErase(results, count);
+		for (double overlap : {1.0, 0.5, 0.1})
+			benchExecute(results, count, overlap);
+		benchGetEntity(results, count);
+		benchRandomAt(results, count);
+	}
+
+	const json output = {
+		{"benchmark", "registry"},
+		{"repetitions", REPETITIONS},
+		{"results", results},
+		{"checksum", checksum}
+	};
+
+	if (argc > 1)
+	{
+		std::ofstream file(argv[1]);
+		file << output.dump(2) << std::endl;
+	}
+	else
+		std::cout << output.dump(2) << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+#include "testutils.hpp"
+
+#include <engine/game/systems/hierarchysystem.hpp>
+#include <engine/game/systems/transformsystem.hpp>
+#include <vector>
+
+static glm::mat4 local(Registry& registry, Entity ent) {
+    auto& transforms = registry.getComponents<Transform>();
+    return TransformSystem::getModelMatrix(*transforms.at(ent), *transforms.cold(ent));
+}
+
+static const glm::mat4& world(Registry& registry, Entity ent) {
+    return registry.getComponents<WorldTransform>().at(ent)->matrix;
+}
+
+int main()
+{
+    Registry registry;
+    HierarchySystem hierarchy;
+    auto& transforms = registry.getComponents<Transform>();
+    auto& parents = registry.getComponents<Parent>();
+
+    auto create = [&](float x) {
+        const Entity ent = registry.create();
+        transforms.insert(ent, Transform{glm::vec3(x, 1.f, 0.f)});
+        return ent;
+    };
+
+    // Children are created before their parents, so the Parent pool is not in depth order.
+    const Entity grandchild = create(5.f);
+    const Entity child = create(3.f);
+    const Entity root = create(2.f);
+    const Entity otherRoot = create(7.f);
+    parents.insert(grandchild, {child});
+    parents.insert(child, {root});
+
+    hierarchy.updateWorldMatrices(registry);
+    registry.clearChanged();
+    const glm::mat4 childWorld = local(registry, root) * local(registry, child);
+    EXPECT(hierarchy.numLevels() == 2, "Sort the hierarchy into levels.");
+    EXPECT(world(registry, root) == local(registry, root) && world(registry, child) == childWorld,
+           "Compose the world matrix of a child.");
+    EXPECT(world(registry, grandchild) == childWorld * local(registry, grandchild), "Parents are computed before their children.");
+
+    transforms.at(root)->position.x = 4.f;
+    transforms.markChanged(root);
+    hierarchy.updateWorldMatrices(registry);
+    registry.clearChanged();
+    EXPECT(world(registry, grandchild) == local(registry, root) * local(registry, child) * local(registry, grandchild),
+           "Changes of a root propagate to all levels.");
+
+    parents.at(grandchild)->entity = otherRoot;
+    parents.markChanged(grandchild);
+    hierarchy.updateWorldMatrices(registry);
+    registry.clearChanged();
+    EXPECT(world(registry, grandchild) == local(registry, otherRoot) * local(registry, grandchild), "Reparent an entity.");
+
+    parents.erase(grandchild);
+    hierarchy.updateWorldMatrices(registry);
+    registry.clearChanged();
+    EXPECT(world(registry, grandchild) == local(registry, grandchild) && hierarchy.numLevels() == 1,
+           "An entity without Parent becomes a root.");
+
+    parents.insert(grandchild, {child});
+    hierarchy.updateWorldMatrices(registry);
+    registry.clearChanged();
+    EXPECT(world(registry, grandchild) == world(registry, child) * local(registry, grandchild), "Add a Parent to a root.");
+
+    // A long chain which is built from the leaf upwards.
+    std::vector<Entity> chain;
+    for (int i = 0; i < 100; ++i) chain.push_back(create(1.f + i % 3));
+    for (int i = 1; i < 100; ++i) parents.insert(chain[i], {chain[i - 1]});
+    hierarchy.updateWorldMatrices(registry);
+    registry.clearChanged();
+    glm::mat4 expected = local(registry, chain[0]);
+    bool ordered = true;
+    for (int i = 1; i < 100; ++i) {
+        expected = expected * local(registry, chain[i]);
+        ordered &= world(registry, chain[i]) == expected;
+    }
+    EXPECT(ordered && hierarchy.numLevels() == 99, "Compute a deep hierarchy level by level.");
+
+    const Entity cycleA = create(1.f);
+    const Entity cycleB = create(1.f);
+    const Entity belowCycle = create(1.f);
+    parents.insert(cycleA, {cycleB});
+    parents.insert(cycleB, {cycleA});
+    parents.insert(belowCycle, {cycleA});
+    transforms.at(root)->position.x = 6.f;
+    transforms.markChanged(root);
+    hierarchy.updateWorldMatrices(registry);
+    registry.clearChanged();
+    EXPECT(world(registry, grandchild) == local(registry, root) * local(registry, child) * local(registry, grandchild),
+           "Parent cycles are skipped without affecting other entities.");
+
+    return testsFailed;
+}
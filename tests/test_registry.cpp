@@ -1,7 +1,14 @@
 #include "testutils.hpp"
 
+#include <engine/game/commandbuffer.hpp>
+#include <engine/game/framesnapshot.hpp>
 #include <engine/game/registry.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <optional>
+#include <utility>
 #include <vector>
 
 struct Foo {
@@ -12,6 +19,46 @@ struct Bar {
     float f;
 };
 
+struct Baz {
+    char c;
+};
+
+struct Marked {};
+struct Hidden {};
+
+struct SplitCold {
+    int value = 7;
+};
+
+struct Split {
+    using ColdPart = SplitCold;
+    int i;
+};
+
+struct Counter {
+    int calls = 0;
+    void count(Entity) { ++calls; }
+};
+
+template <int N>
+struct Numbered {
+    int value;
+};
+
+// Insert Numbered<N> for every N into _ent.
+template <int... N>
+void insertNumbered(Registry& _registry, Entity _ent, std::integer_sequence<int, N...>) {
+    (_registry.getComponents<Numbered<N>>().insert(_ent, {N}), ...);
+}
+
+template <int... N>
+size_t countNumbered(Registry& _registry, std::integer_sequence<int, N...>) {
+    return (_registry.getComponents<Numbered<N>>().size() + ...);
+}
+
+static int numErased = 0;
+static void countErased(Entity) { ++numErased; }
+
 int main() 
 {
     Registry registry;
@@ -51,7 +98,7 @@ int main()
     }
 
     {
-        ComponentAccess<Foo> fooComps = registry.getComponents<Foo>();
+        ComponentAccess<Foo>& fooComps = registry.getComponents<Foo>();
         const ComponentAccess<Foo> constFooComps = fooComps;
         for (int i = 0; i < static_cast<int>(entities.size()); ++i) 
         {
@@ -106,4 +153,643 @@ int main()
             EXPECT(pBar->f == -1.f, "Action can change components.");
         }
     }
+
+    {
+        auto view = registry.view<Entity, Foo, Bar>();
+        EXPECT(view.sizeHint() == registry.getComponents<Bar>().size(), "View is driven by the smallest pool.");
+
+        int visited = 0;
+        view.each([&](Entity ent, Foo& foo, Bar& bar) {
+            EXPECT(registry.getComponents<Foo>().at(ent) == &foo, "View provides the correct components.");
+            ++visited;
+        });
+        int withFoo = 0;
+        for (Entity ent : registry.getComponents<Bar>().getEntities()) withFoo += registry.getComponents<Foo>().hasEntity(ent);
+        EXPECT(visited == withFoo && withFoo > 0, "View visits all entities with every component.");
+
+        Entity late = registry.create();
+        registry.getComponents<Foo>().insert(late, Foo{42});
+        registry.getComponents<Bar>().insert(late, Bar{42.f});
+        EXPECT(view.contains(late), "View sees entities added after its creation.");
+
+        registry.execute<Entity, Foo>([&](Entity& ent, Foo& foo) {
+            if (foo.i % 2) registry.erase(ent);
+        });
+        int odd = 0;
+        registry.execute<Foo>([&](const Foo& foo) { odd += foo.i % 2; });
+        EXPECT(odd == 0, "The current entity can be erased during execute.");
+    }
+
+    {
+        Registry parallelRegistry;
+        for (int i = 0; i < 10000; ++i) {
+            Entity ent = parallelRegistry.create();
+            parallelRegistry.getComponents<Foo>().insert(ent, Foo{i});
+            if (i % 2 == 0) parallelRegistry.getComponents<Bar>().insert(ent, Bar{1.f});
+        }
+
+        parallelRegistry.executeParallel<Foo, const Bar>([](Foo& foo, const Bar& bar) { foo.i += static_cast<int>(bar.f); });
+
+        bool correct = true;
+        parallelRegistry.execute<const Foo>([&](const Foo& foo) { correct &= foo.i % 2 == 1; });
+        EXPECT(correct, "Parallel execute processes every entity exactly once.");
+
+        utils::ThreadPool threadPool(4);
+        parallelRegistry.view<Foo>().eachParallel([](Foo& foo) { foo.i *= 2; }, threadPool);
+        correct = true;
+        parallelRegistry.execute<const Foo>([&](const Foo& foo) { correct &= foo.i % 4 == 2; });
+        EXPECT(correct, "Parallel execute with multiple workers.");
+    }
+
+    {
+        Registry bufferedRegistry;
+        std::vector<Entity> existing;
+        for (int i = 0; i < 100; ++i) {
+            existing.push_back(bufferedRegistry.create());
+            bufferedRegistry.getComponents<Foo>().insert(existing.back(), Foo{i});
+        }
+
+        CommandBuffer commands;
+        bufferedRegistry.executeParallel<Entity, const Foo>([&](Entity& ent, const Foo& foo) {
+            if (foo.i % 2) {
+                commands.erase(ent);
+                commands.erase(ent);
+            } else
+                commands.insert(ent, Bar{static_cast<float>(foo.i)});
+        });
+        CommandBuffer::PendingEntity pending = commands.create();
+        commands.insert(pending, Foo{-1});
+        commands.insert(pending, Bar{-1.f});
+        commands.remove<Foo>(existing[0]);
+
+        EXPECT(bufferedRegistry.getComponents<Foo>().size() == 100, "Recorded commands are deferred.");
+        commands.flush(bufferedRegistry);
+        EXPECT(commands.empty(), "Flush clears the buffer.");
+
+        EXPECT(bufferedRegistry.getComponents<Foo>().size() == 50, "Erase entities on flush.");
+        EXPECT(bufferedRegistry.getComponents<Bar>().size() == 51, "Insert components on flush.");
+        EXPECT(!bufferedRegistry.getComponents<Foo>().at(existing[0]), "Remove components on flush.");
+        EXPECT(bufferedRegistry.getComponents<Bar>().at(existing[4])->f == 4.f, "Inserted components keep their value.");
+
+        int created = 0;
+        bufferedRegistry.execute<const Foo, const Bar>([&](const Foo& foo, const Bar& bar) { created += foo.i == -1 && bar.f == -1.f; });
+        EXPECT(created == 1, "Create entities on flush.");
+
+        commands.insert(existing[2], Marked{});
+        commands.insert(existing[4], Marked{});
+        commands.insert(commands.create(), Marked{});
+        bufferedRegistry.getTags<Hidden>().insert(existing[6]);
+        commands.remove<Hidden>(existing[6]);
+        commands.flush(bufferedRegistry);
+        EXPECT(bufferedRegistry.getTags<Marked>().size() == 3 && bufferedRegistry.getTags<Marked>().hasEntity(existing[4]) &&
+                   bufferedRegistry.getTags<Hidden>().size() == 0,
+               "Insert and remove tags on flush.");
+
+        const CommandBuffer::PendingEntity pendingSplit = commands.create();
+        commands.insert(pendingSplit, Split{1}, SplitCold{11});
+        commands.insert(existing[2], Split{2});
+        commands.flush(bufferedRegistry);
+        int splitColds = 0;
+        bufferedRegistry.execute<const Split, Cold<const Split>>([&](const Split& split, const SplitCold& cold) {
+            splitColds += split.i == 1 ? cold.value == 11 : cold.value == 7;
+        });
+        EXPECT(splitColds == 2, "Insert cold parts on flush.");
+    }
+
+    {
+        Registry pagedRegistry;
+        ComponentAccess<Foo>& foos = pagedRegistry.getComponents<Foo>();
+        Entity first = pagedRegistry.create();
+        Foo* firstFoo = &foos.insert(first, Foo{-1});
+
+        std::vector<Entity> spawned;
+        for (int i = 0; i < 5000; ++i) spawned.push_back(pagedRegistry.create());
+        foos.insertRange(spawned, Foo{7});
+        EXPECT(foos.size() == 5001 && foos.at(spawned.back())->i == 7, "Insert a range of components.");
+        EXPECT(foos.at(first) == firstFoo && firstFoo->i == -1, "Components do not move when the pool grows.");
+
+        const size_t capacity = foos.capacity();
+        for (size_t i = 0; i < spawned.size(); i += 2) pagedRegistry.erase(spawned[i]);
+        EXPECT(foos.capacity() == capacity, "Erasing components retains the capacity.");
+        EXPECT(foos.at(spawned[1])->i == 7 && !foos.at(spawned[0]), "Swap and pop keeps other components intact.");
+
+        const ComponentAccess<Foo> copy = foos;
+        EXPECT(copy.size() == foos.size() && copy.at(spawned[4999])->i == 7, "Copy a paged pool.");
+        foos.shrinkToFit();
+        EXPECT(foos.capacity() < capacity && foos.at(first)->i == -1, "Release unused pages.");
+
+        ComponentAccess<Bar> rare;
+        const Entity farAway{10000000};
+        rare.insert(farAway, Bar{3.f});
+        EXPECT(rare.at(farAway)->f == 3.f && !rare.at(Entity{farAway.id - 1}) && !rare.at(Entity{12}),
+               "Sparse index supports large entity ids.");
+        rare.erase(farAway);
+        EXPECT(!rare.hasEntity(farAway) && rare.size() == 0, "Erase a component with a large entity id.");
+    }
+
+    {
+        Registry trackedRegistry;
+        std::vector<Entity> tracked;
+        for (int i = 0; i < 10; ++i) {
+            tracked.push_back(trackedRegistry.create());
+            trackedRegistry.getComponents<Foo>().insert(tracked.back(), Foo{i});
+        }
+        trackedRegistry.getComponents<Bar>().insert(tracked[3], Bar{1.f});
+
+        int changed = 0;
+        trackedRegistry.execute<Changed<const Foo>>([&](const Foo&) { ++changed; });
+        EXPECT(changed == 10, "Inserted components are flagged as changed.");
+
+        trackedRegistry.clearChanged();
+        auto& foos = trackedRegistry.getComponents<Foo>();
+        foos.markChanged(tracked[3]);
+        foos.markChanged(tracked[9]);
+        trackedRegistry.erase(tracked[0]);
+
+        std::vector<int> visited;
+        trackedRegistry.execute<Changed<Foo>>([&](Foo& foo) { visited.push_back(foo.i); });
+        std::sort(visited.begin(), visited.end());
+        EXPECT(visited == std::vector<int>({3, 9}), "Only changed components are visited and flags move with swap and pop.");
+
+        changed = 0;
+        trackedRegistry.executeParallel<Entity, Changed<const Foo>, Bar>([&](Entity& ent, const Foo&, Bar&) { changed += ent == tracked[3]; });
+        EXPECT(changed == 1, "Changed filter combines with other components.");
+        EXPECT(!foos.isChanged(tracked[4]) && foos.isChanged(tracked[3]), "Query the change flag of a single entity.");
+    }
+
+    {
+        Registry groupedRegistry;
+        std::vector<Entity> grouped;
+        for (int i = 0; i < 20; ++i) {
+            grouped.push_back(groupedRegistry.create());
+            groupedRegistry.getComponents<Foo>().insert(grouped.back(), Foo{i});
+            if (i % 2) groupedRegistry.getComponents<Bar>().insert(grouped.back(), Bar{static_cast<float>(i)});
+        }
+
+        auto group = groupedRegistry.group<Entity, Foo, const Bar>();
+        EXPECT(group.size() == 10, "Group existing entities on creation.");
+        const auto& foos = groupedRegistry.getComponents<Foo>();
+        const auto& bars = groupedRegistry.getComponents<Bar>();
+        bool packed = true;
+        for (size_t i = 0; i < group.size(); ++i)
+            packed &= foos.getEntities()[i] == bars.getEntities()[i] && foos.atIndex(i).i == static_cast<int>(bars.atIndex(i).f);
+        EXPECT(packed, "Owned pools are sorted identically.");
+
+        groupedRegistry.getComponents<Bar>().insert(grouped[0], Bar{0.f});
+        groupedRegistry.erase(grouped[5]);
+        groupedRegistry.getComponents<Foo>().erase(grouped[7]);
+        EXPECT(group.size() == 9, "Inserting and erasing components updates the group.");
+
+        int sum = 0;
+        group.each([&](Entity& ent, Foo& foo, const Bar& bar) {
+            sum += foo.i;
+            if (foo.i == 9) groupedRegistry.erase(ent);
+        });
+        EXPECT(sum == 1 + 3 + 9 + 11 + 13 + 15 + 17 + 19 && group.size() == 8, "Iterate over a group.");
+
+        auto nested = groupedRegistry.group<Foo, Bar, Baz>();
+        groupedRegistry.getComponents<Baz>().insert(grouped[11], Baz{});
+        groupedRegistry.getComponents<Baz>().insert(grouped[2], Baz{});
+        std::atomic<int> count = 0;
+        groupedRegistry.group<const Foo, const Bar>().eachParallel([&](const Foo&, const Bar&) { ++count; });
+        EXPECT(nested.size() == 1 && count == 8 && foos.getEntities()[0] == grouped[11], "Nested groups are prefixes of each other.");
+    }
+
+    {
+        Registry batchRegistry;
+        std::vector<Entity> batch;
+        for (int i = 0; i < 100; ++i) {
+            batch.push_back(batchRegistry.create());
+            batchRegistry.getComponents<Foo>().insert(batch.back(), Foo{i});
+            if (i % 3 == 0) batchRegistry.getComponents<Bar>().insert(batch.back(), Bar{static_cast<float>(i)});
+        }
+
+        batchRegistry.erase(batch[1]);
+        EXPECT(!batchRegistry.getComponents<Foo>().hasEntity(batch[1]) && batchRegistry.getComponents<Foo>().size() == 99,
+               "Erase an entity through its component mask.");
+
+        std::vector<Entity> despawned(batch.begin(), batch.begin() + 50);
+        despawned.push_back(batch[10]);
+        batchRegistry.erase(despawned);
+        EXPECT(batchRegistry.getComponents<Foo>().size() == 50 && batchRegistry.getComponents<Bar>().size() == 17,
+               "Erase a batch of entities.");
+        EXPECT(!batchRegistry.isAlive(batch[10]) && batchRegistry.isAlive(batch[50]), "Batch erase skips dead and duplicate entities.");
+
+        const Entity reused = batchRegistry.create();
+        const Entity next = batchRegistry.create();
+        EXPECT(!(reused == next) && !batchRegistry.getComponents<Foo>().hasEntity(reused), "Reused ids start without components.");
+    }
+
+    {
+        Registry savedRegistry;
+        std::vector<Entity> saved;
+        for (int i = 0; i < 3000; ++i) {
+            saved.push_back(savedRegistry.create());
+            savedRegistry.getComponents<Foo>().insert(saved.back(), Foo{i});
+            if (i % 2) savedRegistry.getComponents<Bar>().insert(saved.back(), Bar{static_cast<float>(i)});
+        }
+        savedRegistry.erase(saved[3]);
+        const EntityRef ref = savedRegistry.getRef(saved[5]);
+        EXPECT(savedRegistry.save("registry_snapshot.bin"), "Save a snapshot.");
+
+        Registry loadedRegistry;
+        auto& loadedFoos = loadedRegistry.getComponents<Foo>();
+        loadedRegistry.getComponents<Foo>().insert(loadedRegistry.create(), Foo{-1});
+        auto group = loadedRegistry.group<Foo, Bar>();
+        EXPECT(loadedRegistry.load("registry_snapshot.bin"), "Load a snapshot.");
+        EXPECT(loadedFoos.size() == 2999 && loadedFoos.at(saved[2999])->i == 2999 && !loadedFoos.at(saved[3]),
+               "Existing pools are replaced by the snapshot.");
+        EXPECT(loadedRegistry.getEntity(ref) && !loadedRegistry.isAlive(saved[3]), "Generations and free ids are restored.");
+        EXPECT(loadedRegistry.getComponents<Bar>().at(saved[7])->f == 7.f && group.size() == 1499, "Components of new pools are restored.");
+
+        loadedRegistry.erase(saved[9]);
+        EXPECT(!loadedRegistry.getComponents<Bar>().hasEntity(saved[9]) && loadedRegistry.create().index() == saved[9].index(),
+               "Component masks are restored.");
+        std::FILE* garbage = std::fopen("registry_snapshot.bin", "wb");
+        std::fputs("not a snapshot", garbage);
+        std::fclose(garbage);
+        EXPECT(!loadedRegistry.load("registry_snapshot.bin") && loadedFoos.size() == 2998, "Reject invalid snapshots.");
+
+        // Layout offsets, see registry.cpp: SnapshotHeader and PoolHeader have 40 bytes, the pool size is at 24.
+        savedRegistry.save("registry_snapshot.bin");
+        std::vector<char> snapshot(1 << 20);
+        std::FILE* file = std::fopen("registry_snapshot.bin", "rb");
+        snapshot.resize(std::fread(snapshot.data(), 1, snapshot.size(), file));
+        std::fclose(file);
+        const size_t poolOffset = 40 + 3000 * sizeof(Entity);
+        uint64_t poolSize;
+        std::memcpy(&poolSize, snapshot.data() + poolOffset + 24, sizeof(poolSize));
+        auto loadModified = [&](size_t _bytes, size_t _offset, uint64_t _value) {
+            std::vector<char> modified(snapshot.begin(), snapshot.begin() + _bytes);
+            if (_offset + sizeof(_value) <= _bytes) std::memcpy(modified.data() + _offset, &_value, sizeof(_value));
+            file = std::fopen("registry_snapshot.bin", "wb");
+            std::fwrite(modified.data(), 1, modified.size(), file);
+            std::fclose(file);
+            return loadedRegistry.load("registry_snapshot.bin");
+        };
+        EXPECT(!loadModified(snapshot.size() / 2, snapshot.size(), 0) && loadedFoos.size() == 2998, "Reject truncated snapshots.");
+        EXPECT(!loadModified(snapshot.size(), poolOffset + 40, ~uint64_t(0)) && loadedFoos.size() == 2998,
+               "Reject snapshots with out of range entities.");
+        EXPECT(!loadModified(snapshot.size(), poolOffset + 40 + poolSize * sizeof(Entity), uint64_t(1) << 40) && loadedFoos.size() == 2998,
+               "Reject snapshots with out of range sparse pages.");
+        EXPECT(!loadModified(snapshot.size(), poolOffset + 24, uint64_t(1) << 60) && loadedFoos.size() == 2998,
+               "Reject snapshots with huge pools.");
+        const size_t sparseOffset = poolOffset + 40 + poolSize * sizeof(Entity) + sizeof(uint64_t);
+        uint64_t entries;
+        std::memcpy(&entries, snapshot.data() + sparseOffset + 4 * sizeof(uint32_t), sizeof(entries));
+        EXPECT(!loadModified(snapshot.size(), sparseOffset + 4 * sizeof(uint32_t), entries >> 32 | entries << 32) && loadedFoos.size() == 2998,
+               "Reject snapshots whose sparse index does not match the entities.");
+        EXPECT(loadModified(snapshot.size(), snapshot.size(), 0) && loadedFoos.size() == 2999, "The unmodified snapshot still loads.");
+
+        // Only the first sparse page is used, so moving it to the second page stays in range.
+        Registry pagedRegistry;
+        for (int i = 0; i < 5000; ++i) {
+            const Entity ent = pagedRegistry.create();
+            if (i < 10) pagedRegistry.getComponents<Foo>().insert(ent, Foo{i});
+        }
+        pagedRegistry.save("registry_snapshot.bin");
+        snapshot.resize(1 << 20);
+        file = std::fopen("registry_snapshot.bin", "rb");
+        snapshot.resize(std::fread(snapshot.data(), 1, snapshot.size(), file));
+        std::fclose(file);
+        EXPECT(!loadModified(snapshot.size(), 40 + 5000 * sizeof(Entity) + 40 + 10 * sizeof(Entity), 1) && loadedFoos.size() == 2999,
+               "Reject snapshots with a moved sparse page.");
+        std::remove("registry_snapshot.bin");
+    }
+
+    {
+        Registry publishedRegistry;
+        FrameSnapshot<Foo, Bar> snapshot;
+        EXPECT(snapshot.acquire().number() == 0 && snapshot.acquire().get<Foo>().size() == 0, "Acquire before the first publish.");
+
+        const Entity ent = publishedRegistry.create();
+        publishedRegistry.getComponents<Foo>().insert(ent, Foo{1});
+        snapshot.publish(publishedRegistry);
+        const auto& first = snapshot.acquire();
+
+        publishedRegistry.getComponents<Foo>().at(ent)->i = 2;
+        publishedRegistry.getComponents<Bar>().insert(ent, Bar{2.f});
+        snapshot.publish(publishedRegistry);
+        snapshot.publish(publishedRegistry);
+        EXPECT(first.number() == 1 && first.get<Foo>().at(ent)->i == 1 && !first.get<Bar>().hasEntity(ent),
+               "Acquired frames are not modified by publish.");
+
+        const auto& latest = snapshot.acquire();
+        int visited = 0;
+        latest.view<Entity, const Foo, const Bar>().each([&](Entity& e, const Foo& foo, const Bar&) { visited += e == ent && foo.i == 2; });
+        EXPECT(latest.number() == 3 && visited == 1, "Acquire the latest frame.");
+    }
+
+    {
+        Registry statsRegistry;
+        auto& foos = statsRegistry.getComponents<Foo>();
+        std::vector<Entity> spawned;
+        for (int i = 0; i < 3000; ++i) {
+            spawned.push_back(statsRegistry.create());
+            foos.insert(spawned.back(), Foo{i});
+        }
+        statsRegistry.erase(std::span<const Entity>(spawned.data(), 1000));
+
+        const PoolStats stats = foos.stats();
+        EXPECT(stats.size == 2000 && stats.capacity == 3 * ComponentAccess<Foo>::PAGE_SIZE && stats.sparseSize == ComponentAccess<Foo>::SPARSE_PAGE_SIZE,
+               "Occupancy of a pool.");
+        EXPECT(stats.inserts == 3000 && stats.erases == 1000 && stats.name.find("Foo") != std::string_view::npos, "Churn and name of a pool.");
+
+        foos.shrinkToFit();
+        const PoolStats shrunk = foos.stats();
+        EXPECT(shrunk.bytes < stats.bytes && shrunk.peakBytes == stats.peakBytes && stats.peakBytes >= stats.bytes, "Peak bytes remain after shrinking.");
+
+        statsRegistry.resetChurn();
+        EXPECT(statsRegistry.stats().size() == 1 && statsRegistry.stats()[0].inserts == 0, "Reset the churn counters.");
+    }
+
+    {
+        Registry prefabRegistry;
+        const Entity existing = prefabRegistry.create();
+        prefabRegistry.getComponents<Foo>().insert(existing, Foo{-1});
+        prefabRegistry.erase(existing);
+
+        const Prefab<Foo, Bar> prefab(Foo{1}, Bar{2.f});
+        const std::vector<Entity> wave = prefabRegistry.instantiate(prefab, 3000, [&](Entity, Foo& foo, Bar&) { foo.i = 5; });
+        int matching = 0;
+        prefabRegistry.execute<Entity, Foo, Bar>([&](Entity& ent, Foo& foo, Bar& bar) {
+            matching += prefabRegistry.isAlive(ent) && foo.i == 5 && bar.f == 2.f;
+        });
+        EXPECT(wave.size() == 3000 && matching == 3000 && prefabRegistry.getComponents<Foo>().capacity() == 3 * ComponentAccess<Foo>::PAGE_SIZE,
+               "Instantiate a prefab.");
+
+        auto group = prefabRegistry.group<Foo, Baz>();
+        Prefab<Baz, Foo> grouped(Baz{}, Foo{3});
+        grouped.get<Baz>().c = 4;
+        int index = 0;
+        const std::vector<Entity> groupedWave = prefabRegistry.instantiate(grouped, 10, [&](Entity, Baz&, Foo& foo) { foo.i = index++; });
+        EXPECT(group.size() == 10 && prefabRegistry.getComponents<Foo>().at(groupedWave[7])->i == 7 &&
+                   prefabRegistry.getComponents<Baz>().at(groupedWave[7])->c == 4,
+               "Instantiate a prefab into a group.");
+    }
+
+    {
+        Registry tagRegistry;
+        auto& marked = tagRegistry.getTags<Marked>();
+        auto& hidden = tagRegistry.getTags<Hidden>();
+        std::vector<Entity> tagged;
+        for (int i = 0; i < 200; ++i) {
+            tagged.push_back(tagRegistry.create());
+            tagRegistry.getComponents<Foo>().insert(tagged.back(), Foo{i});
+            if (i % 2 == 0) marked.insert(tagged.back());
+            if (i % 3 == 0) hidden.insert(tagged.back());
+        }
+        marked.insert(tagged[0]);
+        EXPECT(marked.size() == 100 && marked.hasEntity(tagged[4]) && !marked.hasEntity(tagged[5]), "Insert tags.");
+
+        int sum = 0;
+        tagRegistry.execute<Foo, const Marked, const Hidden>([&](Foo& foo, const Marked&, const Hidden&) { sum += foo.i; });
+        int expected = 0;
+        for (int i = 0; i < 200; i += 6) expected += i;
+        const auto view = tagRegistry.view<Foo, const Marked, const Hidden>();
+        EXPECT(sum == expected && view.contains(tagged[6]) && !view.contains(tagged[4]), "Filter a view by tags.");
+
+        tagRegistry.erase(tagged[6]);
+        tagRegistry.erase(std::span<const Entity>(tagged.data(), 3));
+        EXPECT(marked.size() == 97 && hidden.size() == 65 && !tagRegistry.getTags<Marked>().hasEntity(tagged[6]),
+               "Erasing an entity removes its tags.");
+
+        EXPECT(tagRegistry.save("registry_snapshot.bin"), "Save a snapshot with tags.");
+        Registry loadedRegistry;
+        EXPECT(loadedRegistry.load("registry_snapshot.bin") && loadedRegistry.getTags<Marked>().size() == 97 &&
+                   loadedRegistry.getTags<Hidden>().hasEntity(tagged[9]),
+               "Tags are restored from snapshots.");
+        std::remove("registry_snapshot.bin");
+    }
+
+    {
+        Registry sortRegistry;
+        std::vector<Entity> sorted;
+        for (int i = 0; i < 3000; ++i) {
+            sorted.push_back(sortRegistry.create());
+            sortRegistry.getComponents<Foo>().insert(sorted.back(), Foo{(i * 7919) % 3000});
+            if (i % 2) sortRegistry.getComponents<Bar>().insert(sorted.back(), Bar{static_cast<float>((i * 7919) % 3000)});
+            if (i % 4 == 1) sortRegistry.getComponents<Baz>().insert(sorted.back(), Baz{1});
+        }
+
+        auto& foos = sortRegistry.getComponents<Foo>();
+        sortRegistry.sort<Foo>([](const Foo& a, const Foo& b) { return a.i < b.i; });
+        bool ordered = true;
+        for (size_t i = 0; i < foos.size(); ++i) ordered &= foos.atIndex(i).i == static_cast<int>(i) && foos.at(foos.getEntities()[i])->i == static_cast<int>(i);
+        EXPECT(ordered, "Sort a pool.");
+
+        auto& bars = sortRegistry.getComponents<Bar>();
+        bars.sortBy([](const Bar& bar) { return -bar.f; });
+        EXPECT(bars.atIndex(0).f == 2999.f && bars.at(bars.getEntities()[0])->f == 2999.f, "Sort a pool by key.");
+
+        auto group = sortRegistry.group<Foo, Bar>();
+        auto inner = sortRegistry.group<Foo, Bar, Baz>();
+        bars.sortBy([](const Bar& bar) { return bar.f; });
+        sortRegistry.sort<Foo>([](const Foo& a, const Foo& b) { return a.i > b.i; });
+        bool intact = true;
+        for (uint32_t i = 0; i < group.size(); ++i) {
+            const Entity ent = foos.getEntities()[i];
+            intact &= bars.getEntities()[i] == ent && static_cast<float>(foos.atIndex(i).i) == bars.atIndex(i).f;
+            if (i > 0 && i != inner.size()) intact &= foos.atIndex(i - 1).i > foos.atIndex(i).i;
+        }
+        for (uint32_t i = 0; i < inner.size(); ++i)
+            intact &= sortRegistry.getComponents<Baz>().getEntities()[i] == foos.getEntities()[i];
+        EXPECT(intact && group.size() == 1500 && inner.size() == 750, "Sorting keeps groups intact.");
+    }
+
+    {
+        Registry signalRegistry;
+        auto& foos = signalRegistry.getComponents<Foo>();
+        Counter inserted;
+        Counter updated;
+        foos.onInsert().connect(ComponentListener::bind<&Counter::count>(inserted));
+        foos.onInsert().connect(ComponentListener::bind<&Counter::count>(inserted));
+        foos.onUpdate().connect(ComponentListener::bind<&Counter::count>(updated));
+        foos.onErase().connect(ComponentListener::bind<&countErased>());
+
+        std::vector<Entity> observed;
+        for (int i = 0; i < 10; ++i) {
+            observed.push_back(signalRegistry.create());
+            foos.insert(observed.back(), Foo{i});
+        }
+        EXPECT(inserted.calls == 10, "Insert emits onInsert once per listener.");
+
+        foos.patch(observed[3], [](Foo& foo) { foo.i = 42; });
+        EXPECT(updated.calls == 1 && foos.at(observed[3])->i == 42 && foos.isChanged(observed[3]), "Patch emits onUpdate.");
+
+        signalRegistry.erase(observed[0]);
+        foos.erase(observed[1]);
+        foos.erase(observed[1]);
+        EXPECT(numErased == 2, "Erase emits onErase.");
+
+        foos.onErase().disconnect(ComponentListener::bind<&countErased>());
+        foos.erase(observed[2]);
+        foos.clear();
+        EXPECT(numErased == 2 && foos.onErase().empty(), "Disconnected listeners are not called.");
+    }
+
+    {
+        Registry concurrentRegistry;
+        std::vector<Entity> erased;
+        for (int i = 0; i < 100; ++i) erased.push_back(concurrentRegistry.create());
+        concurrentRegistry.erase(std::span<const Entity>(erased.data(), 50));
+
+        utils::ThreadPool threadPool(4);
+        std::vector<Entity> reserved(1000);
+        CommandBuffer commands;
+        threadPool.parallelFor(reserved.size(), 10, [&](size_t begin, size_t end) {
+            concurrentRegistry.createConcurrent(std::span<Entity>(reserved.data() + begin, end - begin));
+            for (size_t i = begin; i < end; ++i) commands.insert(reserved[i], Foo{static_cast<int>(i)});
+        });
+
+        std::vector<Entity> unique = reserved;
+        std::sort(unique.begin(), unique.end());
+        const bool distinct = std::adjacent_find(unique.begin(), unique.end()) == unique.end();
+        EXPECT(distinct && !concurrentRegistry.isAlive(reserved[0]) && !concurrentRegistry.isAlive(erased[0]),
+               "Reserve distinct entities concurrently.");
+
+        commands.flush(concurrentRegistry);
+        bool alive = true;
+        for (size_t i = 0; i < reserved.size(); ++i)
+            alive &= concurrentRegistry.isAlive(reserved[i]) && concurrentRegistry.getComponents<Foo>().at(reserved[i])->i == static_cast<int>(i);
+        EXPECT(alive && concurrentRegistry.getComponents<Foo>().size() == 1000, "Reserved entities are committed on flush.");
+
+        const Entity single = concurrentRegistry.createConcurrent();
+        const Entity created = concurrentRegistry.create();
+        EXPECT(concurrentRegistry.isAlive(single) && concurrentRegistry.isAlive(created) && single != created,
+               "Create commits pending reservations.");
+    }
+
+    {
+        // Drain a long free list from several workers at once with mixed batch sizes.
+        Registry drainRegistry;
+        std::vector<Entity> freed;
+        for (int i = 0; i < 4000; ++i) freed.push_back(drainRegistry.create());
+        drainRegistry.erase(freed);
+
+        drainRegistry.createConcurrent(std::span<Entity>());
+        const Entity firstFree = drainRegistry.createConcurrent();
+        EXPECT(firstFree.index() == freed.back().index(), "Reserving no entities leaves the free list unchanged.");
+
+        utils::ThreadPool threadPool(8);
+        std::vector<Entity> reserved(6000);
+        threadPool.parallelFor(reserved.size(), 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end;) {
+                const size_t count = std::min<size_t>(i % 4, end - i);
+                if (count == 0) {
+                    reserved[i++] = drainRegistry.createConcurrent();
+                    continue;
+                }
+                drainRegistry.createConcurrent(std::span<Entity>(reserved.data() + i, count));
+                i += count;
+            }
+        });
+        drainRegistry.commitReserved();
+
+        std::vector<uint32_t> indices;
+        bool alive = true;
+        for (Entity ent : reserved) {
+            indices.push_back(ent.index());
+            alive &= drainRegistry.isAlive(ent);
+        }
+        std::sort(indices.begin(), indices.end());
+        const bool distinct = std::adjacent_find(indices.begin(), indices.end()) == indices.end() &&
+                              std::find(indices.begin(), indices.end(), firstFree.index()) == indices.end();
+        const size_t numRecycled = std::count_if(indices.begin(), indices.end(), [](uint32_t _index) { return _index < 4000; });
+        EXPECT(distinct && alive && numRecycled == 3999, "Concurrent reservations never hand out an index twice.");
+    }
+
+    {
+        Registry splitRegistry;
+        auto& splits = splitRegistry.getComponents<Split>();
+        std::vector<Entity> split;
+        for (int i = 0; i < 3000; ++i) {
+            split.push_back(splitRegistry.create());
+            if (i % 2)
+                splits.insert(split.back(), Split{i}, SplitCold{i});
+            else
+                splits.insert(split.back(), Split{i});
+        }
+        EXPECT(splits.cold(split[2])->value == 7 && splits.cold(split[3])->value == 3, "Insert the cold part of a split component.");
+
+        for (int i = 0; i < 3000; i += 3) splitRegistry.erase(split[i]);
+        splits.sortBy([](const Split& s) { return -s.i; });
+        bool aligned = true;
+        splitRegistry.execute<const Split, Cold<const Split>>([&](const Split& s, const SplitCold& cold) { aligned &= cold.value == (s.i % 2 ? s.i : 7); });
+        for (size_t i = 0; i < splits.size(); ++i) aligned &= &splits.coldAtIndex(i) == splits.cold(splits.getEntities()[i]);
+        EXPECT(aligned && splits.size() == 2000, "Cold parts follow erase and sort.");
+
+        EXPECT(splitRegistry.save("registry_snapshot.bin"), "Save a snapshot with cold parts.");
+        Registry loadedRegistry;
+        EXPECT(loadedRegistry.load("registry_snapshot.bin") && loadedRegistry.getComponents<Split>().cold(split[5])->value == 5 &&
+                   loadedRegistry.getComponents<Split>().cold(split[4])->value == 7,
+               "Cold parts are restored from snapshots.");
+        std::remove("registry_snapshot.bin");
+
+        ComponentAccess<Split> copy = splits;
+        EXPECT(copy.cold(split[7])->value == 7 && copy.at(split[7])->i == 7, "Copy cold parts.");
+    }
+
+    {
+        // More pools than a ComponentMask has bits.
+        Registry wideRegistry;
+        const auto numbers = std::make_integer_sequence<int, MAX_COMPONENTS + 8>{};
+        const Entity first = wideRegistry.create();
+        const Entity second = wideRegistry.create();
+        insertNumbered(wideRegistry, first, numbers);
+        insertNumbered(wideRegistry, second, numbers);
+        EXPECT(countNumbered(wideRegistry, numbers) == 2 * (MAX_COMPONENTS + 8), "Create more pools than mask bits.");
+
+        wideRegistry.erase(first);
+        const bool kept = wideRegistry.getComponents<Numbered<MAX_COMPONENTS + 7>>().at(second)->value == MAX_COMPONENTS + 7 &&
+                          wideRegistry.getComponents<Numbered<0>>().hasEntity(second);
+        EXPECT(countNumbered(wideRegistry, numbers) == MAX_COMPONENTS + 8 && kept, "Erase entities with components beyond the mask bits.");
+
+        const Entity ents[] = {second};
+        wideRegistry.erase(ents);
+        EXPECT(countNumbered(wideRegistry, numbers) == 0, "Erase multiple entities with components beyond the mask bits.");
+    }
+
+    {
+        // A stale handle whose index is reused by an entity with a component of a pool which is not bound yet.
+        Registry savedRegistry;
+        const Entity stale = savedRegistry.create();
+        savedRegistry.erase(stale);
+        const Entity reused = savedRegistry.create();
+        savedRegistry.getComponents<Foo>().insert(reused, Foo{3});
+        EXPECT(savedRegistry.save("registry_snapshot.bin"), "Save a snapshot with a reused index.");
+
+        Registry loadedRegistry;
+        EXPECT(loadedRegistry.load("registry_snapshot.bin"), "Load a snapshot with a reused index.");
+        std::remove("registry_snapshot.bin");
+        const Entity staleEntities[] = {stale};
+        loadedRegistry.erase(staleEntities);
+        EXPECT(loadedRegistry.isAlive(reused) && loadedRegistry.getComponents<Foo>().at(reused)->i == 3,
+               "Erasing a stale handle keeps the components of unbound pools.");
+    }
+
+    {
+        Registry smallRegistry;
+        const Entity small = smallRegistry.create();
+        smallRegistry.getComponents<Foo>().insert(small, Foo{1});
+        smallRegistry.getTags<Marked>().insert(small);
+        EXPECT(smallRegistry.save("registry_snapshot.bin"), "Save a snapshot with a single entity.");
+
+        Registry largeRegistry;
+        for (int i = 0; i < 5000; ++i) {
+            const Entity ent = largeRegistry.create();
+            largeRegistry.getComponents<Foo>().insert(ent, Foo{i});
+            largeRegistry.getComponents<Bar>().insert(ent, Bar{static_cast<float>(i)});
+            largeRegistry.getTags<Marked>().insert(ent);
+        }
+        EXPECT(largeRegistry.load("registry_snapshot.bin"), "Load a snapshot with fewer entities than the registry.");
+        std::remove("registry_snapshot.bin");
+        EXPECT(largeRegistry.getComponents<Foo>().size() == 1 && largeRegistry.getComponents<Foo>().at(small)->i == 1 &&
+                   largeRegistry.getComponents<Bar>().size() == 0 && largeRegistry.getTags<Marked>().size() == 1,
+               "Pools and tags of the larger registry are replaced.");
+        const Entity created = largeRegistry.create();
+        EXPECT(created.index() == 1 && !largeRegistry.getComponents<Bar>().hasEntity(created), "Create entities after loading a smaller snapshot.");
+    }
+
+    return testsFailed;
 }
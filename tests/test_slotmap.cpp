@@ -1,6 +1,9 @@
 #include "testutils.hpp"
 
+#include <engine/utils/containers/slotmap.hpp>
 #include <engine/utils/containers/weakslotmap.hpp>
+#include <algorithm>
+#include <numeric>
 #include <unordered_set>
 
 int constructed = 0;
@@ -83,6 +86,44 @@ int main()
 		}
 	}
 	EXPECT(constructed + moveConstructed == destroyed, "All constructed objects have been destroyed after a move.");
+	{
+		utils::WeakSlotMap<int, true> slotMap(utils::TypeHolder<int>{});
+		for (int i = 0; i < 100; ++i)
+			slotMap.template emplace<int>(i, i);
+
+		auto range = slotMap.template iterate<int>();
+		static_assert(std::random_access_iterator<decltype(range.begin())>);
+		static_assert(std::is_same_v<std::iterator_traits<decltype(range.begin())>::iterator_category, std::input_iterator_tag>);
+		auto it = range.begin() + 10;
+		it += 5;
+		EXPECT(it - range.begin() == 15 && it[2].second == 17 && (*(it - 1)).first == 14 && it < range.end(),
+			"Random access on an iterator range.");
+
+		const auto chunks = range.chunks(30);
+		int sum = 0;
+		for (const auto& chunk : chunks)
+			for (const auto& [key, value] : chunk) sum += value;
+		EXPECT(chunks.size() == 4 && chunks.back().size() == 10 && sum == 99 * 100 / 2, "Split an iterator range into chunks.");
+
+		slotMap.template emplace<int>(100, 100);
+		EXPECT(range.size() == 101 && chunks.back().size() == 10, "A range over the whole container sees later insertions.");
+	}
+	{
+		utils::SlotMap<int, int> slotMap;
+		for (int i = 0; i < 100; ++i)
+			slotMap.emplace(i, 99 - i);
+
+		static_assert(std::random_access_iterator<utils::SlotMap<int, int>::Iterator>);
+		auto last = std::max_element(slotMap.begin(), slotMap.end());
+		EXPECT(last - slotMap.begin() == 0 && slotMap.end() - slotMap.begin() == 100 && slotMap.begin()[42] == 57 && (last + 42).key() == 42,
+			"Random access on slot map iterators.");
+
+		const auto chunks = slotMap.chunks(32);
+		int sum = 0;
+		for (const auto& chunk : chunks)
+			sum += std::accumulate(chunk.begin(), chunk.end(), 0);
+		EXPECT(chunks.size() == 4 && chunks.back().size() == 4 && sum == 99 * 100 / 2, "Split a slot map into chunks.");
+	}
 
 	return testsFailed;
 }
\ No newline at end of file
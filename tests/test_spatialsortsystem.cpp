@@ -0,0 +1,44 @@
+#include "testutils.hpp"
+
+#include <engine/game/systems/spatialsortsystem.hpp>
+#include <vector>
+
+int main()
+{
+    // Cell 2^20 is at the origin, so bit 20 of every axis ends up in bits 60 to 62.
+    constexpr uint64_t ORIGIN = uint64_t(7) << 60;
+    EXPECT(SpatialSortSystem::mortonCode(glm::vec3(0.f), 1.f) == ORIGIN, "Code of the origin.");
+    EXPECT(SpatialSortSystem::mortonCode(glm::vec3(1.f, 0.f, 0.f), 1.f) == (ORIGIN | 1) &&
+               SpatialSortSystem::mortonCode(glm::vec3(0.f, 1.f, 0.f), 1.f) == (ORIGIN | 2) &&
+               SpatialSortSystem::mortonCode(glm::vec3(0.f, 0.f, 1.f), 1.f) == (ORIGIN | 4),
+           "The axes are interleaved as x, y, z.");
+    // x = 0b011 -> bits 0, 3; y = 0b101 -> bits 1, 7; z = 0b110 -> bits 5, 8.
+    EXPECT(SpatialSortSystem::mortonCode(glm::vec3(3.f, 5.f, 6.f), 1.f) == (ORIGIN | 0b110101011), "Interleave multiple bits.");
+    EXPECT(SpatialSortSystem::mortonCode(glm::vec3(3.9f, 5.5f, 6.1f), 1.f) == (ORIGIN | 0b110101011) &&
+               SpatialSortSystem::mortonCode(glm::vec3(6.f, 10.f, 12.f), 2.f) == (ORIGIN | 0b110101011),
+           "Positions are quantized to cells.");
+    EXPECT(SpatialSortSystem::mortonCode(glm::vec3(-1.f, 0.f, 0.f), 1.f) == (uint64_t(0b110) << 60 | 0x0249249249249249ull),
+           "Negative cells borrow from bit 20.");
+    EXPECT(SpatialSortSystem::mortonCode(glm::vec3(-1e9f), 1.f) == 0 && SpatialSortSystem::mortonCode(glm::vec3(1e9f), 1.f) == 0x7fffffffffffffffull,
+           "Clamp to the 21 bits of every axis.");
+
+    Registry registry;
+    SpatialSortSystem spatialSort(1);
+    auto& transforms = registry.getComponents<Transform>();
+    std::vector<Entity> sameCell;
+    for (int i = 0; i < 100; ++i) {
+        transforms.insert(registry.create(), Transform{glm::vec3(static_cast<float>(100 - i), 0.f, 0.f)});
+        sameCell.push_back(registry.create());
+        transforms.insert(sameCell.back(), Transform{glm::vec3(0.5f, 0.f, 0.f)});
+    }
+    spatialSort.update(registry);
+    bool sorted = true;
+    for (size_t i = 1; i < transforms.size(); ++i)
+        sorted &= transforms.atIndex(i - 1).position.x <= transforms.atIndex(i).position.x;
+    EXPECT(sorted, "Sort by position.");
+    bool stable = true;
+    for (size_t i = 0; i < sameCell.size(); ++i) stable &= transforms.getEntities()[i] == sameCell[i];
+    EXPECT(stable, "Entities within a cell keep their order.");
+
+    return testsFailed;
+}
@@ -0,0 +1,93 @@
+#include "testutils.hpp"
+
+#include <engine/game/systemscheduler.hpp>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+struct Position {
+    float x;
+};
+
+struct Velocity {
+    float x;
+};
+
+struct Selected {};
+
+int main()
+{
+    Registry registry;
+    for (int i = 0; i < 1000; ++i) {
+        Entity ent = registry.create();
+        registry.getComponents<Position>().insert(ent, Position{0.f});
+        registry.getComponents<Velocity>().insert(ent, Velocity{1.f});
+    }
+
+    utils::ThreadPool threadPool(4);
+    SystemScheduler scheduler;
+    std::vector<int> order;
+    std::atomic<int> readers = 0;
+
+    scheduler.addSystem<Position, const Velocity>("move", [&](Registry& _registry) {
+        _registry.execute<Position, const Velocity>([](Position& pos, const Velocity& vel) { pos.x += vel.x; });
+        order.push_back(0);
+    });
+    scheduler.addSystem<const Position>("read1", [&](Registry& _registry) { ++readers; });
+    scheduler.addSystem<const Position>("read2", [&](Registry& _registry) { ++readers; });
+    scheduler.addSystem<Velocity>("accelerate", [&](Registry& _registry) {
+        _registry.execute<Velocity>([](Velocity& vel) { vel.x *= 2.f; });
+    });
+    scheduler.addExclusiveSystem("spawn", [&](Registry& _registry) {
+        _registry.getComponents<Position>().insert(_registry.create(), Position{-1.f});
+        order.push_back(1);
+    });
+    scheduler.addSystem<Position>("reset", [&](Registry& _registry) {
+        _registry.execute<Position>([](Position& pos) { pos.x = 0.f; });
+        order.push_back(2);
+    });
+
+    for (int frame = 0; frame < 10; ++frame) {
+        scheduler.run(registry, threadPool);
+
+        bool moved = true;
+        registry.execute<Position, const Velocity>([&](Position& pos, const Velocity& vel) { moved &= pos.x == 0.f; });
+        EXPECT(moved, "Conflicting systems run in the order they were added.");
+    }
+
+    EXPECT(readers == 20, "All systems are executed once per run.");
+    EXPECT(order.size() == 30, "All systems are executed once per run.");
+    bool ordered = true;
+    for (size_t i = 0; i < order.size(); ++i) ordered &= order[i] == static_cast<int>(i % 3);
+    EXPECT(ordered, "Exclusive systems run between the systems added before and after.");
+    EXPECT(registry.getComponents<Position>().size() == 1010, "Exclusive systems can change the registry.");
+
+    // Each system waits until the other one has started, which only succeeds if they overlap.
+    SystemScheduler disjointScheduler;
+    std::atomic<int> started = 0;
+    std::atomic<int> overlapped = 0;
+    auto waitForOther = [&](Registry&) {
+        ++started;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (started < 2 && std::chrono::steady_clock::now() < deadline) {}
+        if (started == 2) ++overlapped;
+    };
+    disjointScheduler.addSystem<Position>("position", waitForOther);
+    disjointScheduler.addSystem<const Velocity>("velocity", waitForOther);
+    disjointScheduler.run(registry, threadPool);
+    EXPECT(overlapped == 2, "Systems with disjoint accesses run concurrently.");
+
+    registry.getComponents<Position>().insert(registry.create(), Position{-1.f});
+    SystemScheduler tagScheduler;
+    size_t numSelected = 0;
+    tagScheduler.addSystem<Selected, const Position>("select", [](Registry& _registry) {
+        _registry.execute<Entity, const Position>([&](Entity ent, const Position& pos) {
+            if (pos.x < 0.f) _registry.getTags<Selected>().insert(ent);
+        });
+    });
+    tagScheduler.addSystem<const Selected>("count", [&](Registry& _registry) { numSelected = _registry.getTags<Selected>().size(); });
+    for (int i = 0; i < 10; ++i) tagScheduler.run(registry, threadPool);
+    EXPECT(numSelected == 1, "Systems can declare tags.");
+
+    return testsFailed;
+}
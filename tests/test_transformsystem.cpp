@@ -0,0 +1,62 @@
+#include "testutils.hpp"
+
+#include <engine/game/systems/transformsystem.hpp>
+#include <vector>
+
+static Transform makeTransform(size_t i) {
+    const float f = static_cast<float>(i);
+    return Transform{glm::vec3(f, -f, 0.5f * f), glm::vec3(0.25f, f * 0.125f, -1.f), glm::vec3(0.f, f, 2.f), glm::vec3(f * 0.375f, 0.f, 0.75f)};
+}
+
+static void integrateScalar(Transform& transform) {
+    transform.position += transform.velocity;
+    transform.rotation += transform.angularVelocity;
+}
+
+static bool equal(const Transform& a, const Transform& b) {
+    return a.position == b.position && a.velocity == b.velocity && a.rotation == b.rotation && a.angularVelocity == b.angularVelocity;
+}
+
+int main()
+{
+    // Counts around the AVX and SSE2 widths, with a sentinel that must not be touched.
+    bool matches = true;
+    for (size_t count = 0; count <= 19; ++count) {
+        std::vector<Transform> transforms;
+        for (size_t i = 0; i <= count; ++i) transforms.push_back(makeTransform(i));
+        std::vector<Transform> expected = transforms;
+        for (size_t i = 0; i < count; ++i) integrateScalar(expected[i]);
+
+        TransformSystem::integrate(transforms.data(), count);
+        for (size_t i = 0; i <= count; ++i) matches &= equal(transforms[i], expected[i]);
+    }
+    EXPECT(matches, "The vectorized kernel matches the scalar integration for any count.");
+
+    // Spans a page boundary, so the kernel runs on one full and one partial page.
+    constexpr size_t NUM_TRANSFORMS = ComponentAccess<Transform>::PAGE_SIZE + 13;
+    Registry registry;
+    auto& transforms = registry.getComponents<Transform>();
+    std::vector<Entity> entities;
+    std::vector<Transform> expected;
+    for (size_t i = 0; i < NUM_TRANSFORMS; ++i) {
+        entities.push_back(registry.create());
+        expected.push_back(makeTransform(i));
+        // Every seventh transform rests.
+        if (i % 7 == 0) expected.back().velocity = expected.back().angularVelocity = glm::vec3(0.f);
+        transforms.insert(entities.back(), expected.back());
+    }
+    registry.clearChanged();
+    TransformSystem::updateTransforms(registry);
+
+    bool pagesMatch = true;
+    bool flagsMatch = true;
+    for (size_t i = 0; i < NUM_TRANSFORMS; ++i) {
+        integrateScalar(expected[i]);
+        pagesMatch &= equal(*transforms.at(entities[i]), expected[i]);
+        flagsMatch &= transforms.isChanged(entities[i]) == (i % 7 != 0);
+    }
+    EXPECT(pagesMatch, "Integrate transforms across a page boundary.");
+    EXPECT(flagsMatch, "Only moving transforms are flagged as changed.");
+
+    return testsFailed;
+}